@@ -10,6 +10,8 @@
 // Project includes
 #include <Configuration.hpp>
 #include <FactorGraph.hpp>
+#include <Features.hpp>
+#include <Selector.hpp>
 #include <Solver.hpp>
 #include <Validator.hpp>
 
@@ -30,6 +32,7 @@ struct ExperimentArgs {
   double fractionParams[6] = {0.04, 0.02, 0.01, 0.005, 0.0025, 0.00125};
   int c = 100;
   double Q = -1;
+  bool autoSelect = false;  // Engine and fraction chosen for every instance
 };
 
 // -----------------------------------------------------------------------------
@@ -83,12 +86,21 @@ void createCNFFiles(ExperimentArgs* args) {
 ExperimentArgs* parseArgs(int argc, char* argv[]) {
   ExperimentArgs* args = new ExperimentArgs();
 
+  // Optional last argument
+  if (argc > 1 && strcmp(argv[argc - 1], "auto") == 0) {
+    args->autoSelect = true;
+    argc--;
+  }
+
   // Check number of arguments
   if (argc != 5 && argc != 6) {
     cout << "Usage:" << endl;
-    cout << "\t./experiment N a random seed" << endl;
-    cout << "\t./experiment N a community seed Q" << endl;
+    cout << "\t./experiment N a random seed [auto]" << endl;
+    cout << "\t./experiment N a community Q seed [auto]" << endl;
     cout << "If seed = 0, random seed is used" << endl;
+    cout << "With auto, the engine and fraction are selected from the "
+            "features of every instance"
+         << endl;
     exit(-1);
   }
 
@@ -133,6 +145,7 @@ int main(int argc, char* argv[]) {
     cout << " - c (communities) = 100" << endl;
     cout << " - Q = " << args->Q << endl;
   }
+  if (args->autoSelect) cout << " - f = auto" << endl;
   cout << endl;
 
   cout << "Setting up experiment environment..." << endl;
@@ -151,6 +164,7 @@ int main(int argc, char* argv[]) {
   Validator validator;
   Solver solver(args->N, args->a, args->s);
   if (args->s == 0) cout << "Random seed: " << solver.initialSeed << endl;
+  cout << "Kernels: " << solver.kernels->name << endl;
 
   cout << "Generating CNF files..." << endl;
   createCNFFiles(args);
@@ -163,13 +177,19 @@ int main(int argc, char* argv[]) {
   int experimentId = 1;
   resultFile.open(args->baseDir + "/result.csv", ofstream::app);
   for (double fraction : args->fractionParams) {
+    // A single run, fraction 0 in the results
+    if (args->autoSelect) fraction = 0;
+
     cout << endl << endl;
     cout << "------------------------------" << endl;
     cout << "Experiment " << experimentId << ":" << endl;
     cout << " - N: " << args->N << endl;
     cout << " - α: " << args->a << endl;
     if (args->Q >= 0) cout << " - Q: " << args->Q << endl;
-    cout << " - f: " << fraction << endl;
+    if (args->autoSelect)
+      cout << " - f: auto" << endl;
+    else
+      cout << " - f: " << fraction << endl;
     cout << "------------------------------" << endl;
 
     // Metrics
@@ -192,7 +212,17 @@ int main(int argc, char* argv[]) {
 
       FactorGraph* graph = new FactorGraph(file);
       chrono::steady_clock::time_point beginSID = chrono::steady_clock::now();
-      AlgorithmResult result = solver.SID(graph, fraction);
+      AlgorithmResult result;
+      if (args->autoSelect) {
+        InstanceFeatures features = ExtractFeatures(graph);
+        EngineChoice choice = SelectEngine(features);
+        cout << "Relative density " << features.relativeDensity
+             << ", modularity " << features.modularity << ": strategy "
+             << choice.strategy << ", f " << choice.fraction << endl;
+        result = SolveWithChoice(solver, graph, choice);
+      } else {
+        result = solver.SID(graph, fraction);
+      }
       chrono::steady_clock::time_point endSID = chrono::steady_clock::now();
 
       // Get result and update metrics
@@ -279,7 +309,7 @@ int main(int argc, char* argv[]) {
     experimentId++;
 
     // If all instances solved, stop experiment, if not, continue with next f
-    if (args->I == totalSATInstances) break;
+    if (args->I == totalSATInstances || args->autoSelect) break;
   }
 
   resultFile.close();
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+#include <Kernels.hpp>
+#include <Solver.hpp>
+#include <ThreadPool.hpp>
+#include <vector>
+
+namespace sat {
+
+// Instances interleaved in one group (one SIMD lane each)
+#define SP_BATCH_LANES 8
+
+// =============================================================================
+// SPBatchGroup
+//
+// Up to SP_BATCH_LANES independent instances stored interleaved: the same
+// clause index of every instance is contiguous in memory, so a sweep updates
+// clause c of all the instances at once with one lane per instance.
+// Instances with fewer clauses, shorter clauses or fewer variables are padded.
+// =============================================================================
+struct SPBatchGroup {
+  int lanes = 0;      // Instances in use
+  int clauses = 0;    // Max enabled clauses of the instances
+  int width = 0;      // Max clause length
+  int variables = 0;  // Max variables
+
+  // Literal (c, j, lane) at index (c * width + j) * SP_BATCH_LANES + lane
+  std::vector<int> var;                // Variable index (0 in padding)
+  std::vector<unsigned char> type;     // 0 negated, 1 positive, 2 padding
+  std::vector<double> survey;
+
+  // Variable (v, lane) at index v * SP_BATCH_LANES + lane
+  std::vector<double> p;
+  std::vector<double> m;
+  std::vector<int> pzero;
+  std::vector<int> mzero;
+
+  // Lanes that already converged are not updated anymore
+  bool done[SP_BATCH_LANES];
+
+  // Scratch space for the kernel (sub surveys and cavity products)
+  std::vector<double> scratch;
+};
+
+// -----------------------------------------------------------------------------
+// Result of SP for one instance of the batch
+// -----------------------------------------------------------------------------
+struct SPBatchResult {
+  AlgorithmResult result = UNCONVERGE;  // CONVERGE or UNCONVERGE
+  int iterations = 0;
+};
+
+// =============================================================================
+// BatchSurveyPropagation
+//
+// SP engine for many small independent instances (parameter scans), where a
+// single sweep is too small to be split between threads. Instances are packed
+// in groups of SP_BATCH_LANES and every group is handled by one thread.
+// Each instance uses its own random stream for the initial surveys, so its
+// result does not depend on the number of threads. The clause order of every
+// sweep is shared by the instances of a group, so the sweeps an instance takes
+// (and its surveys, within spEpsilon) depend on the instances grouped with it.
+// The final surveys are stored back in the edges of every FactorGraph.
+// =============================================================================
+class BatchSurveyPropagation {
+ public:
+  unsigned long seed;
+  int spMaxIt = 1000;
+  double spEpsilon = 0.001;
+  int numThreads = 1;
+  const Kernels* kernels;
+
+ public:
+  explicit BatchSurveyPropagation(unsigned long seed);
+
+  // ---------------------------------------------------------------------------
+  // Run
+  //
+  // Runs SP over the enabled clauses of all the graphs and returns the result
+  // of each one in the same order
+  // ---------------------------------------------------------------------------
+  std::vector<SPBatchResult> Run(const std::vector<FactorGraph*>& graphs);
+
+ private:
+  void runGroup(const std::vector<FactorGraph*>& graphs, int first, int lanes,
+                std::vector<SPBatchResult>& results);
+};
+
+}  // namespace sat
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+#include <vector>
+
+namespace sat {
+
+// =============================================================================
+// BiasQueue
+//
+// Indexed binary max-heap of variables keyed by the absolute value of their
+// bias (evalValue). Ties are broken by id, the same total order used by the
+// decimation, so the top of the queue is the next variable SID would fix.
+// The key of a variable is copied when it is inserted or updated: later
+// changes of evalValue are not seen until Update is called again.
+// Variables with a NaN bias go after all the others.
+// =============================================================================
+class BiasQueue {
+ private:
+  std::vector<int> heap;        // Variable indexes (id - 1)
+  std::vector<int> position;    // Position of every variable in heap or -1
+  std::vector<double> key;      // Key of every variable in the queue
+  std::vector<Variable*> vars;  // Variable of every index
+
+ public:
+  // ---------------------------------------------------------------------------
+  // Reset
+  //
+  // Empties the queue and prepares it for the variables of the graph
+  // ---------------------------------------------------------------------------
+  void Reset(const std::vector<Variable*>& variables);
+
+  // Inserts the variable or moves it to the place of its current bias
+  void Update(Variable* var);
+
+  // Removes the variable if it is in the queue
+  void Remove(Variable* var);
+
+  // Variable with the largest bias. The queue must not be empty
+  inline Variable* Top() const { return vars[heap[0]]; }
+
+  inline bool Contains(const Variable* var) const {
+    return position[var->id - 1] >= 0;
+  }
+  inline bool empty() const { return heap.empty(); }
+  inline size_t size() const { return heap.size(); }
+
+ private:
+  inline bool before(int lvar, int rvar) const {
+    if (key[lvar] != key[rvar]) return key[lvar] > key[rvar];
+    return lvar < rvar;
+  }
+  void place(size_t i, int var);
+  void siftUp(size_t i);
+  void siftDown(size_t i);
+};
+
+}  // namespace sat
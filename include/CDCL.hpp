@@ -0,0 +1,120 @@
+#pragma once
+
+#include <Solver.hpp>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace sat {
+
+// =============================================================================
+// CDCL
+//
+// Compact conflict driven clause learning solver for the residual formula
+// left by SID. Two watched literals per clause, first UIP learning, VSIDS
+// branching with phase saving and Luby restarts. Every reduceBase conflicts
+// (growing by reduceIncrement) half of the learnt clauses, the ones with the
+// most decision levels (LBD), are deleted.
+// Fully deterministic: same clauses in the same order give the same model.
+//
+// Variables are numbered from 1 and literals are given as in DIMACS (v or -v).
+// =============================================================================
+class CDCL {
+ public:
+  long maxConflicts = 100000;  // INDETERMINATE after this many (0: no limit)
+  int restartBase = 100;       // Conflicts of one unit of the Luby sequence
+  double varDecay = 0.95;
+  int reduceBase = 2000;
+  int reduceIncrement = 300;
+
+  // When set, Solve stops with CANCELLED as soon as it is true
+  const std::atomic<bool>* cancel = nullptr;
+
+  // Solve stops with TIMEOUT after this point in time
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::time_point::max();
+
+  // Metrics
+  long totalConflicts = 0;
+  long totalDecisions = 0;
+  long totalPropagations = 0;
+  int totalRestarts = 0;
+  long totalDeleted = 0;  // Learnt clauses deleted
+
+ private:
+  int numVars;
+  bool unsat = false;
+
+  // Internal literal of variable v (from 0): 2 * v, or 2 * v + 1 if negated.
+  // The first two literals of every clause are the watched ones
+  std::vector<std::vector<int>> clauses;
+  std::vector<std::vector<int>> watches;  // Clauses watching each literal
+  std::vector<int> lbd;  // Decision levels of a learnt clause, 0 if original
+  std::vector<int> learnts;  // Learnt clauses not deleted
+
+  // Assignment: -1 unassigned, 0 false, 1 true
+  std::vector<signed char> values;
+  std::vector<int> level;
+  std::vector<int> reason;  // Clause that implied the variable, -1 if none
+  std::vector<int> trail;
+  std::vector<int> trailLimits;  // Trail size at the start of every level
+  size_t propagated = 0;         // Trail literals already propagated
+
+  // VSIDS: max heap of the variables by activity, ties by smaller index
+  std::vector<double> activity;
+  double varIncrement = 1.0;
+  std::vector<int> heap;
+  std::vector<int> heapPosition;  // -1 if not in the heap
+  std::vector<char> phase;        // Last value of every variable
+
+  // Variables of the clause being learnt, and its literals before the
+  // implied ones are dropped
+  std::vector<char> seen;
+  std::vector<int> marked;
+  std::vector<long> levelStamp;  // Last conflict that counted each level
+
+ public:
+  explicit CDCL(int numVars);
+
+  // ---------------------------------------------------------------------------
+  // AddClause
+  //
+  // Adds a clause before solving. Returns false if the formula is already
+  // unsatisfiable (empty clause or conflicting units)
+  // ---------------------------------------------------------------------------
+  bool AddClause(const std::vector<int>& literals);
+
+  // ---------------------------------------------------------------------------
+  // Solve
+  //
+  // SAT, CONTRADICTION if the formula is unsatisfiable, INDETERMINATE if the
+  // conflict budget runs out, TIMEOUT or CANCELLED
+  // ---------------------------------------------------------------------------
+  AlgorithmResult Solve();
+
+  // Value of variable v (from 1) in the model, after Solve returned SAT
+  inline bool Value(int v) const { return values[v - 1] == 1; }
+
+ private:
+  inline int decisionLevel() const { return trailLimits.size(); }
+  inline int litValue(int lit) const {
+    signed char value = values[lit >> 1];
+    return value < 0 ? -1 : value ^ (lit & 1);
+  }
+
+  void enqueue(int lit, int from);
+  int propagate();
+  int analyze(int conflict, std::vector<int>& learnt);
+  void backtrack(int toLevel);
+  int attach(const std::vector<int>& literals, int levels);
+  void reduceLearnts();
+  int pickBranch();
+
+  void bumpVariable(int v);
+  void heapInsert(int v);
+  void heapUp(int i);
+  void heapDown(int i);
+  bool heapBefore(int a, int b) const;
+};
+
+}  // namespace sat
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+#include <vector>
+
+namespace sat {
+
+// -----------------------------------------------------------------------------
+// DetectCommunities
+//
+// Label propagation over the variables of the graph (two variables are
+// neighbours if they share an enabled clause). Every variable takes the label
+// that is most frequent among its neighbours until no label changes or
+// maxRounds is reached. The order is fixed, so the result is deterministic.
+//
+// Returns the community of every variable (indexed by id - 1), numbered from
+// 0 to totalCommunities - 1. Assigned variables get their own community.
+// -----------------------------------------------------------------------------
+std::vector<int> DetectCommunities(FactorGraph* fg, int maxRounds = 20);
+
+}  // namespace sat
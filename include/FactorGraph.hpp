@@ -65,6 +65,13 @@ class Variable {
   // ---------------------------------------------------------------------------
   void AssignValue(const bool newValue);
 
+  // ---------------------------------------------------------------------------
+  // UnassignValue
+  //
+  // Sets assigned to false. The graph is not updated (see AssignmentStep)
+  // ---------------------------------------------------------------------------
+  void UnassignValue();
+
   // ---------------------------------------------------------------------------
   // operator<<
   //
@@ -73,6 +80,18 @@ class Variable {
   friend std::ostream& operator<<(std::ostream& os, const Variable* var);
 };
 
+// Clauses are classified by length when the graph is loaded, so SP can run a
+// specialised kernel for each class
+#define LONG_CLAUSE_LENGTH 64
+enum ClauseBucket {
+  BINARY_CLAUSE,      // 2 literals (fixed size kernel)
+  TERNARY_CLAUSE,     // 3 literals (fixed size kernel)
+  QUATERNARY_CLAUSE,  // 4 literals (fixed size kernel)
+  MEDIUM_CLAUSE,      // 1 or 5 to LONG_CLAUSE_LENGTH literals (stack buffers)
+  LONG_CLAUSE,        // More than LONG_CLAUSE_LENGTH literals (heap buffers)
+  TOTAL_CLAUSE_BUCKETS
+};
+
 // =============================================================================
 // Clause
 //
@@ -85,6 +104,7 @@ class Clause {
   const unsigned id;
   bool enabled;
   int trueLiterals = 0;
+  ClauseBucket bucket = MEDIUM_CLAUSE;
 
   std::vector<Edge*> allNeighbourEdges;
 
@@ -112,6 +132,15 @@ class Clause {
   // ---------------------------------------------------------------------------
   void Dissable();
 
+  // ---------------------------------------------------------------------------
+  // UpdateState
+  //
+  // Recompute the clause and its edges from the current assignment: the clause
+  // is disabled if an assigned variable satisfies it, otherwise it is enabled
+  // with the edges of the unassigned variables
+  // ---------------------------------------------------------------------------
+  void UpdateState();
+
   // ---------------------------------------------------------------------------
   // countTrueLiterals
   //
@@ -177,6 +206,28 @@ class Edge {
   friend std::ostream& operator<<(std::ostream& os, const Edge* e);
 };
 
+// =============================================================================
+// AssignmentStep
+//
+// Variables assigned by one decision: the decided variable and the ones
+// assigned by unit propagation after it. Clauses and edges disabled by the
+// step are the ones around these variables, so Revert only recomputes them.
+// Steps can be reverted in any order, not only the last one.
+// =============================================================================
+class AssignmentStep {
+ public:
+  std::vector<Variable*> variables;
+
+ public:
+  // ---------------------------------------------------------------------------
+  // Revert
+  //
+  // Unassigns the variables of the step and updates the state of their
+  // clauses. Clauses still satisfied by other assignments stay disabled
+  // ---------------------------------------------------------------------------
+  void Revert();
+};
+
 // =============================================================================
 // FactorGraph
 //
@@ -184,6 +235,11 @@ class Edge {
 // valid DIMACS CNF file.
 // =============================================================================
 class FactorGraph {
+ private:
+  // Variables are stored contiguously so passes over all of them (biases,
+  // subproducts) walk memory in order
+  std::vector<Variable> variableStorage;
+
  public:
   std::vector<Variable*> variables;
   std::vector<Clause*> clauses;
@@ -198,8 +254,26 @@ class FactorGraph {
   // Build the Variables, Clauses and Edges of the CNF
   // ---------------------------------------------------------------------------
   explicit FactorGraph(std::ifstream& file);
+
+  // ---------------------------------------------------------------------------
+  // FactorGraph copy constructor
+  //
+  // Deep copy with the same topology, ids and neighbour order, and the current
+  // state (assignments, enabled flags and surveys) of the other graph.
+  // Subproducts and biases are not copied, SP computes them again
+  // ---------------------------------------------------------------------------
+  FactorGraph(const FactorGraph& other);
+  FactorGraph& operator=(const FactorGraph&) = delete;
   ~FactorGraph();
 
+  // ---------------------------------------------------------------------------
+  // CopyState
+  //
+  // Copies assignments, enabled flags and surveys from a graph of the same
+  // CNF (e.g. a copy of this one)
+  // ---------------------------------------------------------------------------
+  void CopyState(const FactorGraph* other);
+
   // ---------------------------------------------------------------------------
   // Getters
   // ---------------------------------------------------------------------------
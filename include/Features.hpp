@@ -0,0 +1,55 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+
+namespace sat {
+
+// -----------------------------------------------------------------------------
+// Features of the formula left in a graph: enabled clauses (their enabled
+// literals) and unassigned variables
+// -----------------------------------------------------------------------------
+struct InstanceFeatures {
+  int variables = 0;  // Unassigned
+  int clauses = 0;    // Enabled
+  int literals = 0;
+  double ratio = 0.0;  // clauses / variables
+
+  double clauseLengthMean = 0.0;
+  double clauseLengthStd = 0.0;
+  double degreeMean = 0.0;  // Enabled clauses of every variable
+  double degreeStd = 0.0;
+
+  // Fraction of positive literals, and mean over the variables of
+  // |positive - negative| / degree (0 balanced, 1 pure literals)
+  double positiveFraction = 0.0;
+  double polarityImbalance = 0.0;
+
+  // Threshold of random k-SAT for the mean clause length, and ratio divided
+  // by it (about 1 for the hardest random instances)
+  double threshold = 0.0;
+  double relativeDensity = 0.0;
+
+  // Modularity of the DetectCommunities partition of the variables, a clause
+  // of length k linking every pair of its variables with weight 1 / (k - 1).
+  // -1 if not computed
+  double modularity = -1.0;
+};
+
+// -----------------------------------------------------------------------------
+// ExtractFeatures
+//
+// One pass over the enabled edges, plus community detection when
+// withModularity is set
+// -----------------------------------------------------------------------------
+InstanceFeatures ExtractFeatures(FactorGraph* fg, bool withModularity = true);
+
+// -----------------------------------------------------------------------------
+// RandomKSATThreshold
+//
+// Satisfiability threshold (clauses per variable) of random k-SAT. Known
+// values for k = 2..7 are interpolated linearly (k may be a mean clause
+// length). Above 7, the asymptotic 2^k ln 2 - (1 + ln 2) / 2
+// -----------------------------------------------------------------------------
+double RandomKSATThreshold(double k);
+
+}  // namespace sat
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+#include <string>
+
+namespace sat {
+
+struct SPBatchGroup;
+
+// =============================================================================
+// Kernels
+//
+// Hot loops of SP, BP and SID. The same code is compiled for several
+// instruction sets (baseline x86-64 with SSE2, AVX2 and AVX-512) and the best
+// one for the running CPU is chosen at startup, so a single binary can be
+// deployed on different machines. All variants give bit-identical results
+// (the build disables floating point contraction).
+// =============================================================================
+struct Kernels {
+  const char* name;
+
+  // Recompute the survey subproducts (p, m, pzero, mzero) of a variable
+  void (*computeSubProducts)(Variable* var);
+
+  // Update the surveys of all the enabled edges of a clause and the
+  // subproducts of its variables. Returns the max survey change (NaN if a
+  // survey was or became NaN). One kernel per clause bucket (see ClauseBucket)
+  double (*updateSurveys[TOTAL_CLAUSE_BUCKETS])(Clause* clause);
+
+  // Compute the biases (Hp, Hz, Hm) and evalValue of a variable
+  void (*evaluateVar)(Variable* var);
+
+  // Same as updateSurveys and evaluateVar with the Belief Propagation
+  // equations. Messages are stored in the survey of the edges
+  double (*updateSurveysBP[TOTAL_CLAUSE_BUCKETS])(Clause* clause);
+  void (*evaluateVarBP)(Variable* var);
+
+  // evaluateVar (or evaluateVarBP if bp) on count variables at once.
+  // Returns the sum of their max bias (polarization for BP)
+  double (*evaluateVars)(Variable* const* vars, int count, bool bp);
+
+  // One SP sweep over a group of interleaved instances, one lane each, in the
+  // given clause order. Stores the max survey change of every lane
+  void (*sweepBatch)(SPBatchGroup* group, const int* order,
+                     double* laneMaxDiff);
+};
+
+// -----------------------------------------------------------------------------
+// SelectKernels
+//
+// Best variant supported by the CPU (checked with CPUID)
+// -----------------------------------------------------------------------------
+const Kernels* SelectKernels();
+
+// -----------------------------------------------------------------------------
+// GetKernels
+//
+// Variant by name (baseline, avx2, avx512) or nullptr if it is not built.
+// The caller must check the CPU supports it.
+// -----------------------------------------------------------------------------
+const Kernels* GetKernels(const std::string& name);
+
+}  // namespace sat
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+#include <functional>
+#include <vector>
+
+namespace sat {
+
+// -----------------------------------------------------------------------------
+// One configuration of SID raced by the portfolio
+// -----------------------------------------------------------------------------
+struct PortfolioConfig {
+  double fraction;
+  int seed;
+  SPSchedule schedule = RANDOM_SCHEDULE;
+};
+
+// -----------------------------------------------------------------------------
+// Result of the portfolio: SAT if a configuration solved the instance (the
+// winner), otherwise the result of the first configuration. Configurations
+// stopped by the winner, or not started, get CANCELLED
+// -----------------------------------------------------------------------------
+struct PortfolioResult {
+  AlgorithmResult result = INDETERMINATE;
+  int winner = -1;
+  std::vector<AlgorithmResult> results;
+};
+
+// =============================================================================
+// Portfolio
+//
+// Races several SID configurations on the same instance, numThreads of them
+// at a time. Each one works on its own copy of the graph with its own Solver
+// (single threaded). The first one that returns SAT cancels the others and
+// its assignment is copied to the given graph.
+// =============================================================================
+class Portfolio {
+ public:
+  std::vector<PortfolioConfig> configs;
+  int numThreads = 1;
+
+  // Optional, applied to every Solver before its configuration
+  std::function<void(Solver&)> setup;
+
+ public:
+  PortfolioResult Run(FactorGraph* graph);
+};
+
+}  // namespace sat
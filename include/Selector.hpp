@@ -0,0 +1,69 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+#include <Features.hpp>
+#include <Solver.hpp>
+#include <vector>
+
+namespace sat {
+
+// How the selected configuration solves the instance
+enum Strategy {
+  SP_DECIMATION,     // SID with SP
+  BP_DECIMATION,     // SID with BP
+  LOCAL_SEARCH_ONLY  // The residual solver on the whole formula
+};
+
+// -----------------------------------------------------------------------------
+// Configuration picked by the selector. The fraction is also used by SID with
+// SP when local search gives up
+// -----------------------------------------------------------------------------
+struct EngineChoice {
+  Strategy strategy = SP_DECIMATION;
+  double fraction = 0.01;
+  int spMaxIt = 1000;
+  double spEpsilon = 0.001;
+  SPSchedule schedule = RANDOM_SCHEDULE;
+  int wsFlipsPerVariable = 0;  // Flips of local search per variable (0: keep)
+};
+
+// -----------------------------------------------------------------------------
+// Row of a selection table: the choice applies to instances with a relative
+// density (ratio / threshold) below maxRelativeDensity and a modularity of at
+// least minModularity (-1: any, also when it was not computed)
+// -----------------------------------------------------------------------------
+struct SelectorRule {
+  double maxRelativeDensity;
+  double minModularity;
+  EngineChoice choice;
+};
+
+// -----------------------------------------------------------------------------
+// DefaultSelectorTable
+//
+// Fitted to the random 3-SAT results in experiments/random (success rate and
+// time of SID for every fraction), and to runs of local search, BP and both
+// schedules on easier random and community instances. BP was never faster
+// than SP there, so no rule picks it
+// -----------------------------------------------------------------------------
+const std::vector<SelectorRule>& DefaultSelectorTable();
+
+// -----------------------------------------------------------------------------
+// SelectEngine
+//
+// Choice of the first rule of the table that matches the features, or of the
+// last rule if none does
+// -----------------------------------------------------------------------------
+EngineChoice SelectEngine(
+    const InstanceFeatures& features,
+    const std::vector<SelectorRule>& table = DefaultSelectorTable());
+
+// -----------------------------------------------------------------------------
+// SolveWithChoice
+//
+// Sets the parameters of the choice in the solver and solves the graph
+// -----------------------------------------------------------------------------
+AlgorithmResult SolveWithChoice(Solver& solver, FactorGraph* graph,
+                                const EngineChoice& choice);
+
+}  // namespace sat
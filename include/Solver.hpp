@@ -1,6 +1,13 @@
 #pragma once
 
+#include <BiasQueue.hpp>
 #include <FactorGraph.hpp>
+#include <Kernels.hpp>
+#include <ThreadPool.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <random>
 
 using namespace std;
@@ -11,6 +18,10 @@ namespace sat {
 // if a number is 0. All numbers below 1.0e-16 are considered 0.
 #define ZERO_EPSILON (1.0e-16)
 
+// Scale of the fixed point sums of biases (2^40). Integer sums are exact, so
+// they give the same result in any order
+#define FIXED_POINT_ONE (1099511627776.0)
+
 enum AlgorithmResult {
   CONVERGE,
   UNCONVERGE,
@@ -18,9 +29,42 @@ enum AlgorithmResult {
   CONTRADICTION,
   SAT,
   INDETERMINATE,
+  CANCELLED,  // Stopped through Solver::cancel
+  TIMEOUT,    // Out of Solver::timeBudget
   WALKSAT  // TODO remove when walksat is implemented
 };
 
+// Message passing algorithm used by the decimation
+enum MessageEngine {
+  SP_ENGINE,  // Survey Propagation
+  BP_ENGINE   // Belief Propagation (cheaper, enough below the clustering)
+};
+
+// Order in which SP updates the clauses
+enum SPSchedule {
+  // Every sweep updates all enabled clauses in a random order
+  RANDOM_SCHEDULE,
+  // Clauses inside a community are iterated to local convergence (one
+  // community per thread), then the clauses between communities are updated
+  COMMUNITY_SCHEDULE
+};
+
+// Solver of the residual formula left at the paramagnetic state
+enum ResidualSolver {
+  WALKSAT_RESIDUAL,      // Local search, SAT or INDETERMINATE
+  CDCL_RESIDUAL,         // Complete search (see CDCL.hpp)
+  WALKSAT_CDCL_RESIDUAL  // CDCL when walksat gives up
+};
+
+// -----------------------------------------------------------------------------
+// DecimationOrder
+//
+// Order in which SID fixes the variables: larger bias (abs of evalValue)
+// first, NaN biases last and ties broken by id. It is a total order, so any
+// selection method (or the BiasQueue) gives the same variables
+// -----------------------------------------------------------------------------
+bool DecimationOrder(const Variable* lvar, const Variable* rvar);
+
 // =============================================================================
 // Solver
 //
@@ -42,18 +86,167 @@ class Solver {
 
   // Algorithm parameters
   double sidFraction;
+  // Variables fixed by every decimation step. 0 means N * sidFraction
+  int sidSelectionSize = 0;
+
+  // Adaptive decimation schedule. The batch of a step is doubled (up to
+  // N * sidMaxFraction) when the last SP call took at most sidFastSweeps
+  // sweeps and the mean max bias is at least sidPolarizedBias, and halved
+  // (down to the size given by the fraction of SID) when SP took more than
+  // sidSlowSweeps sweeps or the mean max bias is below sidPolarizedBias
+  bool sidAdaptiveFraction = false;
+  double sidMaxFraction = 0.04;
+  int sidFastSweeps = 20;
+  int sidSlowSweeps = 50;
+  double sidPolarizedBias = 0.55;
+
+  // Backtracking Survey Propagation (BSP). Before a decimation step, the
+  // decisions whose support for their value (bias without the assignment) is
+  // below bspUnfixBias are unfixed, weakest first and at most bspRatio times
+  // the batch, together with the variables their unit propagation assigned.
+  // SP then runs again before the batch is chosen. Backtracking stops after
+  // bspMaxUnfixed variables have been unfixed (0: no limit)
+  bool sidBacktracking = false;
+  double bspRatio = 0.5;
+  double bspUnfixBias = 0.1;
+  int bspMaxUnfixed = 0;
+
+  // Contradictions allowed in a SID run before giving up (0: the first one
+  // ends the run). A decision that leads to a contradiction is undone and the
+  // variable takes the other value. If that fails too, the whole decimation
+  // step is undone and SP runs again before a step with half the batch. The
+  // variables fixed by spEarlyFixing are retried the same way
+  int sidMaxRetries = 0;
+
+  // Failed literal probing. Before any candidate of a step is fixed, both
+  // values of every candidate are tried with UP and undone. If only one value
+  // fails, the other one is implied and fixed without using a retry (with
+  // sidProbeSkip, a candidate whose preferred value fails is left for the
+  // next step instead). If both fail, a retry is used and the step is undone
+  bool sidProbing = false;
+  bool sidProbeSkip = false;
+
+  // Batch fixing. The whole batch takes the values given by the biases at the
+  // start of the step, and their unit propagation runs in parallel rounds
+  // (variables are claimed atomically). Only if that ends in a conflict is
+  // the step fixed one variable at a time as usual
+  bool sidBatchFixing = false;
+
+  // Times SID may restart when SP does not converge (0: the run ends with
+  // UNCONVERGE). The decimation step before the failure is undone, the
+  // surveys of the last converged SP are restored and the ones around the
+  // undone variables are reseeded, then the step is tried again with half the
+  // batch
+  int sidMaxRestarts = 0;
+
+  // Branching for the tree search over decimation choices (see TreeSearch).
+  // When onBranch is set and the bias of the last variable of a batch is
+  // within sidBranchGap of the next candidates (at most sidBranchWidth - 1 of
+  // them), onBranch gets the graph before the step and, for every close
+  // candidate, the decisions (variable id, value) of the batch with that
+  // candidate instead of the last variable
+  double sidBranchGap = 0.0;
+  int sidBranchWidth = 2;
+  function<void(const FactorGraph*, const vector<pair<unsigned, bool>>&)>
+      onBranch;
+
+  // Start of SID for a branch: keep the surveys of the graph instead of
+  // random ones and fix these decisions with UP before the first SP
+  bool sidKeepSurveys = false;
+  vector<pair<unsigned, bool>> sidInitialDecisions;
+
+  // Checkpointing. Every sidCheckpointSteps decimation steps (0: never) the
+  // state of the run is written to sidCheckpointPath: assignments, enabled
+  // flags, surveys, trail, random generator and counters. ResumeSID goes on
+  // from such a file with the same parameters and gives the same result as
+  // the run that wrote it
+  string sidCheckpointPath;
+  int sidCheckpointSteps = 0;
+
+  // Keep the unassigned variables in a queue ordered by bias and evaluate
+  // again only the ones whose subproducts changed, instead of evaluating and
+  // selecting from all of them in every decimation step
+  bool sidIncrementalBiases = true;
   double paramagneticState = 0.01;
 
+  // Switch to the residual solver before the paramagnetic state. At the start
+  // of every decimation step, the residual formula goes to the residual
+  // solver when it has at most sidResidualVariables unassigned variables, or
+  // its relative density (see Features.hpp) is below sidResidualDensity
+  // (0: never). Then more SP calls cost more than solving it. If the residual
+  // solver gives up, its assignment is dropped and SID goes on; it is tried
+  // again when the residual has half the variables. The density needs a pass
+  // over the residual, so it is checked again only when an eighth of the
+  // variables of the last check has been assigned
+  int sidResidualVariables = 0;
+  double sidResidualDensity = 0.0;
+
+  // SP parameters. Also used by BP when engine is BP_ENGINE
+  MessageEngine engine = SP_ENGINE;
   int spMaxIt = 1000;
   double spEpsilon = 0.001;
+  SPSchedule spSchedule = RANDOM_SCHEDULE;
+  int spLocalMaxIt = 20;  // Max sweeps of a community per global iteration
+
+  // Compute the biases inside the SP sweep expected to be the last one (warm
+  // started or previous diff below spFuseFactor * spEpsilon) instead of in a
+  // separate pass over the variables
+  bool spFuseBiases = true;
+  double spFuseFactor = 10.0;
+
+  // Fix (with UP) the variables whose bias stays at least spEarlyFixBias
+  // towards the same value for spEarlyFixSweeps consecutive sweeps, and go on
+  // with SP on the reduced graph. Only for RANDOM_SCHEDULE
+  bool spEarlyFixing = false;
+  double spEarlyFixBias = 0.95;
+  int spEarlyFixSweeps = 5;
 
   int wsMaxTries = 10;
   int wsMaxFlips = 100;
   double wsNoise = 0.57;
 
+  // The CDCL residual solver gives up (INDETERMINATE) after cdclMaxConflicts
+  // conflicts. An unsatisfiable residual is a CONTRADICTION
+  ResidualSolver residualSolver = WALKSAT_RESIDUAL;
+  long cdclMaxConflicts = 100000;
+
+  // Parallel execution
+  // In deterministic mode every parallel path uses static scheduling and
+  // fixed reduction trees, so the results are identical for any numThreads.
+  // Otherwise partial results are combined in completion order.
+  int numThreads = 1;
+  bool deterministic = true;
+  int parallelGrain = 1024;  // Elements per task (fixes the reduction tree)
+
+  // Hot loops compiled for the instruction set of the CPU (see Kernels.hpp)
+  const Kernels* kernels;
+
+  // When set, SID, SP and walksat stop with CANCELLED as soon as it is true
+  const atomic<bool>* cancel = nullptr;
+
+  // Wall clock budget of a SID run in seconds (0: no limit). SP sweeps,
+  // decimation steps and the residual solver check it and stop with TIMEOUT,
+  // leaving in the graph the best assignment found: the partial assignment
+  // of the decimation, with the best one walksat reached for the residual
+  double timeBudget = 0.0;
+
   // Metrics
   int totalSPIterations = 0;
+  int totalSPLocalSweeps = 0;  // Sweeps of the communities, added over all
+                               // of them (COMMUNITY_SCHEDULE)
   int totalSIDIterations = 0;
+  int totalEarlyFixed = 0;  // Variables fixed by spEarlyFixing
+  int totalUnfixed = 0;     // Variables unfixed by sidBacktracking
+  int totalRefixedOpposite = 0;  // Unfixed variables fixed again with the
+                                 // other value
+  int totalRetries = 0;     // Contradictions recovered by sidMaxRetries
+  int totalRestarts = 0;    // SP failures recovered by sidMaxRestarts
+  int totalFailedLiterals = 0;  // Found by sidProbing
+  int totalBatchFallbacks = 0;  // Conflicts of sidBatchFixing
+  int totalResidualSwitches = 0;  // Residual solver calls before the
+                                  // paramagnetic state
+  long totalConflicts = 0;  // Conflicts of the CDCL residual solver
+  int bestSatisfiedClauses = 0;  // By the assignment left after TIMEOUT
 
  public:
   // inline void setSeed(int seed) { _randomGenerator.seed(seed); }
@@ -62,14 +255,178 @@ class Solver {
 
   explicit Solver(int N, double a, int seed);
 
+  inline bool cancelled() const {
+    return cancel && cancel->load(memory_order_relaxed);
+  }
+
+  inline bool timedOut() const {
+    return timeBudget > 0.0 && chrono::steady_clock::now() >= deadline;
+  }
+
   AlgorithmResult SID(FactorGraph* graph, double fraction);
 
+  // ---------------------------------------------------------------------------
+  // ResumeSID
+  //
+  // SID from the checkpoint at path, written by a run on the same CNF (graph
+  // is fresh from the file). INDETERMINATE if the checkpoint can't be read
+  // ---------------------------------------------------------------------------
+  AlgorithmResult ResumeSID(FactorGraph* graph, double fraction,
+                            const string& path);
+
+  // ---------------------------------------------------------------------------
+  // SurveyPropagation
+  //
+  // SP (BP with BP_ENGINE) on the enabled clauses of graph, starting from the
+  // surveys in its edges as in a decimation step after the first one. When it
+  // converges, the biases of the unassigned variables are up to date and
+  // sumMaxBias is the sum of their max bias, the values SID decimates with
+  // ---------------------------------------------------------------------------
+  AlgorithmResult SurveyPropagation(FactorGraph* graph, double& sumMaxBias);
+
+  // ---------------------------------------------------------------------------
+  // LocalSearch
+  //
+  // The residual solver on the whole formula left in graph, without SP. On
+  // any result but SAT or TIMEOUT the variables are left unassigned
+  // ---------------------------------------------------------------------------
+  AlgorithmResult LocalSearch(FactorGraph* graph);
+
+  // ---------------------------------------------------------------------------
+  // SelectVariables
+  //
+  // Moves the next count variables of vars[first, end) in DecimationOrder,
+  // sorted, to vars[first, first + count) without sorting the rest (in
+  // parallel with numThreads). Returns how many were available
+  // ---------------------------------------------------------------------------
+  size_t SelectVariables(vector<Variable*>& vars, size_t first, size_t count);
+
+ private:
+  // Worker threads, (re)built when numThreads changes
+  unique_ptr<ThreadPool> pool;
+
+  // Community of every variable (COMMUNITY_SCHEDULE)
+  vector<int> communities;
+
+  // SP sweep schedule: clauses (positions in the sweep order) grouped in
+  // waves that share no variable
+  vector<int> varWave;
+  vector<int> waveStart;
+  vector<int> waveClauses;
+
+  // The surveys come from a previous SP call (the first sweep may be the last)
+  bool spWarmStart = false;
+
+  // Biases computed by the last SP sweep
+  vector<int> varLastClause;
+  bool fusedBiasesReady = false;
+  double fusedSumMaxBias = 0.0;
+
+  // Incremental biases (sidIncrementalBiases): queue of the unassigned
+  // variables, variables whose subproducts changed since they were queued (as
+  // flags and as a list of the first biasDirtyCount entries) and fixed point
+  // max bias of every queued variable (LLONG_MIN if NaN)
+  BiasQueue biasQueue;
+  vector<char> biasDirty;
+  vector<Variable*> biasDirtyList;
+  atomic<size_t> biasDirtyCount{0};
+  vector<long long> biasFixed;
+  long long biasFixedSum = 0;
+  int biasNaNs = 0;
+
+  // Consecutive sweeps every variable has been polarised (spEarlyFixing)
+  vector<int> polarizedSweeps;
+
+  // Trail of decisions (sidBacktracking): one step per decided variable, the
+  // step of every decided variable (-1 if none) and the step being recorded
+  bool recordTrail = false;
+  vector<AssignmentStep> trail;
+  vector<int> decisionStep;
+  vector<signed char> unfixedValue;  // Value before unfixing (-1 none)
+  int currentStep = -1;
+
+  // Surveys of the last converged SP (sidMaxRestarts), in fg->edges order
+  vector<double> convergedSurveys;
+
+  // End of the timeBudget of the current SID run
+  chrono::steady_clock::time_point deadline;
+
+  // Value claimed by every variable during batch fixing: 0 none, 1 false,
+  // 2 true. All 0 between steps. Sized for the graph of the last SID call
+  unique_ptr<atomic<unsigned char>[]> claims;
+  size_t claimsSize = 0;
+
+  // Checkpoint read by the next SID call (ResumeSID)
+  string resumePath;
+
+  // State of the decimation schedule kept between steps (checkpointed)
+  struct SIDProgress {
+    double batchScale;     // Adaptive schedule
+    int retryBatch;        // Batch limit after a rolled back step (0 if none)
+    size_t lastStepStart;  // First trail step of the last decimation step
+    int lastBatch;         // Batch of the last decimation step
+    int failedResidual;    // Variables of the last residual given up (0 none)
+    int densityResidual;   // Variables at the last density check (0 none)
+    int unfixedLast;       // The last step unfixed decisions (SP runs again)
+  };
+
  private:
+  ThreadPool* getPool();
+  void startBudget();
+  inline double updateClause(Clause* clause) {
+    double maxConvDiffInClause =
+        engine == BP_ENGINE ? kernels->updateSurveysBP[clause->bucket](clause)
+                            : kernels->updateSurveys[clause->bucket](clause);
+
+    // Unchanged surveys (a change of 0, not NaN) leave the subproducts exactly
+    // as they were
+    if (sidIncrementalBiases && maxConvDiffInClause != 0.0) {
+      for (Edge* edge : clause->allNeighbourEdges) {
+        if (edge->enabled && !edge->variable->assigned)
+          markBiasDirty(edge->variable);
+      }
+    }
+    return maxConvDiffInClause;
+  }
+  // Concurrent clause updates share no variables, so only the slot in the
+  // dirty list needs to be atomic
+  inline void markBiasDirty(Variable* var) {
+    char& dirty = biasDirty[var->id - 1];
+    if (dirty) return;
+    dirty = 1;
+    biasDirtyList[biasDirtyCount++] = var;
+  }
+  inline void evaluateVar(Variable* var) {
+    if (engine == BP_ENGINE)
+      kernels->evaluateVarBP(var);
+    else
+      kernels->evaluateVar(var);
+  }
+  AlgorithmResult timeout();
+  AlgorithmResult solveResidual();
   AlgorithmResult walksat();
+  AlgorithmResult cdcl(const vector<Variable*>& variables,
+                       const vector<Clause*>& clauses);
   AlgorithmResult surveyPropagation();
-  double updateSurveys(Clause* clause);
+  AlgorithmResult communitySurveyPropagation();
+  double sweepClauses(const vector<Clause*>& order, bool withBiases = false);
+  bool earlyFixVariables();
   void computeSubProducts();
-  void evaluateVar(Variable* var);
+  double evaluateVars(const vector<Variable*>& vars);
+  void resetBiasQueue();
+  double updateBiasQueue();
+  void forgetBias(Variable* var);
+  bool decideVariable(Variable* var, bool value);
+  bool probe(Variable* var, bool value);  // UP of the value, then undone
+  void revertStep(int step);
+  double fixedSupport(Variable* var);
+  int unfixVariables(int maxUnfix);  // Returns the variables unfixed
+  void restartFromConverged(size_t firstStep);
+  void branchDecimation(int batch);
+  bool residualIsCheap(SIDProgress& progress);
+  bool writeCheckpoint(const SIDProgress& progress);
+  bool readCheckpoint(const string& path, SIDProgress& progress);
+  bool fixBatch(const vector<Variable*>& batch);
   bool assignVariable(Variable* var, bool value);
   bool cleanGraph(Variable* var);
   bool unitPropagation(Clause* clause);
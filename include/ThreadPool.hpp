@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sat {
+
+// =============================================================================
+// ThreadPool
+//
+// Fixed set of worker threads used by the parallel paths of the solver.
+// The calling thread always takes part in the work as thread 0, so a pool of
+// size 1 has no workers and runs everything inline.
+//
+// Two scheduling policies are available:
+//  - Static: task t always runs on thread (t % size). Together with per-task
+//    output slots this makes every result independent of the timing.
+//  - Dynamic: threads grab the next free task. Better load balance, but the
+//    order in which tasks finish is not reproducible.
+// =============================================================================
+class ThreadPool {
+ public:
+  // Task signature: (taskIndex, threadIndex)
+  typedef std::function<void(int, unsigned)> Task;
+
+ private:
+  std::vector<std::thread> workers;
+
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  std::condition_variable allDone;
+
+  // Current job. Protected by mutex except the task counter
+  const Task* job = nullptr;
+  int jobTasks = 0;
+  bool jobStatic = true;
+  std::atomic<int> nextTask;
+  unsigned long generation = 0;
+  unsigned pendingWorkers = 0;
+  bool stopping = false;
+
+ public:
+  // ---------------------------------------------------------------------------
+  // ThreadPool constructor
+  //
+  // Creates size - 1 workers. A size of 0 is treated as 1.
+  // ---------------------------------------------------------------------------
+  explicit ThreadPool(unsigned size);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  inline unsigned size() const { return workers.size() + 1; }
+
+  // ---------------------------------------------------------------------------
+  // Run
+  //
+  // Executes task(t, thread) for every t in [0, numTasks) and blocks until all
+  // of them have finished.
+  // ---------------------------------------------------------------------------
+  void Run(int numTasks, const Task& task, bool staticSchedule);
+
+ private:
+  void workerLoop(unsigned threadIndex);
+  void runTasks(unsigned threadIndex);
+};
+
+// -----------------------------------------------------------------------------
+// TreeSum
+//
+// Adds the partial results in a fixed pairwise order so the rounding only
+// depends on the number of partials, not on who computed them or when.
+// -----------------------------------------------------------------------------
+double TreeSum(std::vector<double>& partials);
+
+}  // namespace sat
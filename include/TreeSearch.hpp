@@ -0,0 +1,53 @@
+#pragma once
+
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+#include <functional>
+#include <vector>
+
+namespace sat {
+
+// -----------------------------------------------------------------------------
+// Result of the tree search: SAT if a branch solved the instance, otherwise
+// the result of the root branch. Branches that did not return SAT (and were
+// not cancelled) are pruned
+// -----------------------------------------------------------------------------
+struct TreeSearchResult {
+  AlgorithmResult result = INDETERMINATE;
+  int branches = 0;  // Created, including the root
+  int explored = 0;  // Run until they finished or were cancelled
+  int pruned = 0;
+};
+
+// =============================================================================
+// TreeSearch
+//
+// Best-first search over the decimation choices of SID. Whenever the bias of
+// the last variable of a batch is close to the bias of the next candidates
+// (branchGap), every alternative batch becomes a new branch: a copy of the
+// graph before the step, with its surveys, plus the decisions of the batch.
+// Pending branches run on numThreads workers, the one with the smallest
+// residual (enabled clauses) first. A branch that ends in a contradiction or
+// does not converge is dropped; the first SAT branch cancels the others and
+// its assignment is copied to the given graph.
+// =============================================================================
+class TreeSearch {
+ public:
+  int seed;
+  double fraction;
+  int numThreads = 1;
+
+  double branchGap = 0.01;  // Max bias difference to branch
+  int branchWidth = 2;      // Alternatives of a step, including its own batch
+  int maxBranches = 64;     // Including the root
+
+  // Optional, applied to every Solver before the search parameters
+  std::function<void(Solver&)> setup;
+
+ public:
+  TreeSearch(int seed, double fraction);
+
+  TreeSearchResult Run(FactorGraph* graph);
+};
+
+}  // namespace sat
@@ -12,13 +12,17 @@ alpha=(3.5, 3.7, 3.9, 4.1, 4.2, 4.21, 4.22, 4.23, 4.24)
 Q=(0.3, 0.5, 0.7, 0.85)
 g=(random,community)
 
+# ./run-experiments.sh auto selects the engine and fraction of every instance
+# instead of trying every fraction
+mode=$1
+
 make clean-all
 make
 
 # random
 for n in "${N[@]}";do
   for a in "${alpha[@]}";do
-    ./build/experiment $n $a random $seed
+    ./build/experiment $n $a random $seed $mode
   done;
 done;
 
@@ -26,7 +30,7 @@ done;
 for n in "${N[@]}";do
   for a in "${alpha[@]}";do
     for q in "${Q[@]}";do
-      ./build/experiment $n $a community $q $seed
+      ./build/experiment $n $a community $q $seed $mode
     done;
   done;
 done;
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <random>
+
+// Project headers
+#include <BatchSurveyPropagation.hpp>
+
+namespace sat {
+
+// =============================================================================
+// BatchSurveyPropagation
+// =============================================================================
+BatchSurveyPropagation::BatchSurveyPropagation(unsigned long seed)
+    : seed(seed), kernels(SelectKernels()) {}
+
+std::vector<SPBatchResult> BatchSurveyPropagation::Run(
+    const std::vector<FactorGraph*>& graphs) {
+  std::vector<SPBatchResult> results(graphs.size());
+  int groups = (graphs.size() + SP_BATCH_LANES - 1) / SP_BATCH_LANES;
+
+  ThreadPool pool(numThreads > 1 ? numThreads : 1);
+  pool.Run(
+      groups,
+      [&](int g, unsigned) {
+        int first = g * SP_BATCH_LANES;
+        int lanes = std::min((int)graphs.size() - first, SP_BATCH_LANES);
+        runGroup(graphs, first, lanes, results);
+      },
+      false);
+
+  return results;
+}
+
+void BatchSurveyPropagation::runGroup(const std::vector<FactorGraph*>& graphs,
+                                      int first, int lanes,
+                                      std::vector<SPBatchResult>& results) {
+  const int W = SP_BATCH_LANES;
+  SPBatchGroup group;
+  group.lanes = lanes;
+
+  // ---------------------------------------
+  // Size of the group (enabled clauses only)
+  // ---------------------------------------
+  std::vector<std::vector<Clause*>> laneClauses(lanes);
+  for (int l = 0; l < lanes; l++) {
+    FactorGraph* fg = graphs[first + l];
+    laneClauses[l] = fg->GetEnabledClauses();
+    group.clauses = std::max(group.clauses, (int)laneClauses[l].size());
+    group.variables = std::max(group.variables, (int)fg->variables.size());
+    for (Clause* clause : laneClauses[l]) {
+      group.width =
+          std::max(group.width, (int)clause->GetEnabledEdges().size());
+    }
+  }
+
+  size_t slots = (size_t)group.clauses * group.width * W;
+  group.var.assign(slots, 0);
+  group.type.assign(slots, 2);
+  group.survey.assign(slots, 0.0);
+  group.p.assign((size_t)group.variables * W, 1.0);
+  group.m.assign((size_t)group.variables * W, 1.0);
+  group.pzero.assign((size_t)group.variables * W, 0);
+  group.mzero.assign((size_t)group.variables * W, 0);
+  group.scratch.assign((size_t)3 * (group.width + 1) * W, 0.0);
+  for (int l = 0; l < W; l++) group.done[l] = l >= lanes;
+
+  // -------------------------------------------------------------------------
+  // Interleave the instances and initialize the surveys with the random
+  // stream of each instance
+  // -------------------------------------------------------------------------
+  for (int l = 0; l < lanes; l++) {
+    std::mt19937 instanceGenerator(seed + first + l);
+    std::uniform_real_distribution<> randomReal01(0, 1);
+
+    for (size_t c = 0; c < laneClauses[l].size(); c++) {
+      int j = 0;
+      for (Edge* edge : laneClauses[l][c]->allNeighbourEdges) {
+        if (!edge->enabled || edge->variable->assigned) continue;
+        size_t s = (c * group.width + j) * W + l;
+        group.var[s] = edge->variable->id - 1;
+        group.type[s] = edge->type;
+        group.survey[s] = randomReal01(instanceGenerator);
+        j++;
+      }
+    }
+
+    // Subproducts of the variables
+    for (size_t s = l; s < slots; s += W) {
+      if (group.type[s] == 2) continue;
+      size_t v = (size_t)group.var[s] * W + l;
+      double& product = group.type[s] ? group.m[v] : group.p[v];
+      int& zeros = group.type[s] ? group.mzero[v] : group.pzero[v];
+      if (1.0 - group.survey[s] > ZERO_EPSILON)
+        product *= 1.0 - group.survey[s];
+      else
+        zeros++;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Sweep all the lanes together until every instance converges. The clause
+  // order is shuffled with the stream of the group
+  // -----------------------------------------------------------------------
+  std::mt19937 groupGenerator(seed ^ (0x9e3779b97f4a7c15ul * (first + 1)));
+  std::vector<int> order(group.clauses);
+  for (int c = 0; c < group.clauses; c++) order[c] = c;
+  double laneMaxDiff[SP_BATCH_LANES];
+
+  for (int it = 0; it < spMaxIt; it++) {
+    std::shuffle(order.begin(), order.end(), groupGenerator);
+    kernels->sweepBatch(&group, order.data(), laneMaxDiff);
+
+    bool allDone = true;
+    for (int l = 0; l < lanes; l++) {
+      if (group.done[l]) continue;
+      results[first + l].iterations++;
+      if (laneMaxDiff[l] <= spEpsilon) {
+        group.done[l] = true;
+        results[first + l].result = CONVERGE;
+      } else {
+        allDone = false;
+      }
+    }
+    if (allDone) break;
+  }
+
+  // ----------------------------------
+  // Store the surveys back in the edges
+  // ----------------------------------
+  for (int l = 0; l < lanes; l++) {
+    for (size_t c = 0; c < laneClauses[l].size(); c++) {
+      int j = 0;
+      for (Edge* edge : laneClauses[l][c]->allNeighbourEdges) {
+        if (!edge->enabled || edge->variable->assigned) continue;
+        edge->survey = group.survey[(c * group.width + j) * W + l];
+        j++;
+      }
+    }
+  }
+}
+
+}  // namespace sat
@@ -0,0 +1,76 @@
+#include <cmath>
+
+// Project headers
+#include <BiasQueue.hpp>
+
+namespace sat {
+
+// =============================================================================
+// BiasQueue
+// =============================================================================
+void BiasQueue::Reset(const std::vector<Variable*>& variables) {
+  heap.clear();
+  position.assign(variables.size(), -1);
+  key.assign(variables.size(), 0.0);
+  vars.assign(variables.begin(), variables.end());
+}
+
+void BiasQueue::Update(Variable* var) {
+  int v = var->id - 1;
+  double bias = std::abs(var->evalValue);
+  key[v] = std::isnan(bias) ? -1.0 : bias;
+
+  if (position[v] < 0) {
+    heap.push_back(v);
+    position[v] = heap.size() - 1;
+  }
+  siftUp(position[v]);
+  siftDown(position[v]);
+}
+
+void BiasQueue::Remove(Variable* var) {
+  int v = var->id - 1;
+  if (position[v] < 0) return;
+  size_t i = position[v];
+
+  int last = heap.back();
+  heap.pop_back();
+  position[v] = -1;
+  if (i == heap.size()) return;
+
+  place(i, last);
+  siftUp(i);
+  siftDown(position[last]);
+}
+
+void BiasQueue::place(size_t i, int var) {
+  heap[i] = var;
+  position[var] = i;
+}
+
+void BiasQueue::siftUp(size_t i) {
+  int var = heap[i];
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (!before(var, heap[parent])) break;
+    place(i, heap[parent]);
+    i = parent;
+  }
+  place(i, var);
+}
+
+void BiasQueue::siftDown(size_t i) {
+  int var = heap[i];
+  while (true) {
+    size_t child = 2 * i + 1;
+    if (child >= heap.size()) break;
+    if (child + 1 < heap.size() && before(heap[child + 1], heap[child]))
+      child++;
+    if (!before(heap[child], var)) break;
+    place(i, heap[child]);
+    i = child;
+  }
+  place(i, var);
+}
+
+}  // namespace sat
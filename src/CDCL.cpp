@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Project headers
+#include <CDCL.hpp>
+
+namespace sat {
+
+namespace {
+
+// Element i (from 0) of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ...
+double luby(int i) {
+  int size = 1, seq = 0;
+  while (size < i + 1) {
+    seq++;
+    size = 2 * size + 1;
+  }
+  while (size - 1 != i) {
+    size = (size - 1) >> 1;
+    seq--;
+    i = i % size;
+  }
+  return std::pow(2.0, seq);
+}
+
+}  // namespace
+
+// =============================================================================
+// CDCL
+// =============================================================================
+CDCL::CDCL(int numVars)
+    : numVars(numVars),
+      watches(2 * numVars),
+      values(numVars, -1),
+      level(numVars, 0),
+      reason(numVars, -1),
+      activity(numVars, 0.0),
+      heapPosition(numVars, -1),
+      phase(numVars, 0),
+      seen(numVars, 0),
+      levelStamp(numVars + 1, -1) {
+  for (int v = 0; v < numVars; v++) heapInsert(v);
+}
+
+bool CDCL::AddClause(const std::vector<int>& literals) {
+  if (unsat) return false;
+
+  std::vector<int> lits;
+  for (int literal : literals) {
+    lits.push_back(2 * (std::abs(literal) - 1) + (literal < 0));
+  }
+  std::sort(lits.begin(), lits.end());
+  lits.erase(std::unique(lits.begin(), lits.end()), lits.end());
+
+  // Tautologies are always satisfied, and the literals fixed at level 0 are
+  // removed (or satisfy the clause)
+  size_t kept = 0;
+  for (size_t i = 0; i < lits.size(); i++) {
+    if (i + 1 < lits.size() && (lits[i] ^ 1) == lits[i + 1]) return true;
+    int value = litValue(lits[i]);
+    if (value == 1) return true;
+    if (value < 0) lits[kept++] = lits[i];
+  }
+  lits.resize(kept);
+
+  if (lits.empty()) {
+    unsat = true;
+  } else if (lits.size() == 1) {
+    enqueue(lits[0], -1);
+    unsat = propagate() >= 0;
+  } else {
+    attach(lits, 0);
+  }
+  return !unsat;
+}
+
+AlgorithmResult CDCL::Solve() {
+  if (unsat || propagate() >= 0) return CONTRADICTION;
+
+  std::vector<int> learnt;
+  long reduceInterval = reduceBase;
+  long nextReduce = totalConflicts + reduceInterval;
+  while (true) {
+    long restartConflicts = luby(totalRestarts) * restartBase;
+    long conflicts = 0;
+
+    while (true) {
+      int conflict = propagate();
+      if (conflict >= 0) {
+        totalConflicts++;
+        conflicts++;
+        if (decisionLevel() == 0) return CONTRADICTION;
+
+        // Decision levels of the learnt clause, before backtracking
+        int backtrackLevel = analyze(conflict, learnt);
+        int levels = 0;
+        for (int lit : learnt) {
+          int clauseLevel = level[lit >> 1];
+          if (levelStamp[clauseLevel] == totalConflicts) continue;
+          levelStamp[clauseLevel] = totalConflicts;
+          levels++;
+        }
+
+        backtrack(backtrackLevel);
+        enqueue(learnt[0], learnt.size() > 1 ? attach(learnt, levels) : -1);
+        varIncrement /= varDecay;
+
+        if (totalConflicts >= nextReduce) {
+          reduceLearnts();
+          reduceInterval += reduceIncrement;
+          nextReduce = totalConflicts + reduceInterval;
+        }
+
+        if (cancel && cancel->load(std::memory_order_relaxed)) return CANCELLED;
+        if (std::chrono::steady_clock::now() >= deadline) return TIMEOUT;
+        if (maxConflicts > 0 && totalConflicts >= maxConflicts)
+          return INDETERMINATE;
+        continue;
+      }
+
+      if (conflicts >= restartConflicts) {
+        backtrack(0);
+        totalRestarts++;
+        break;
+      }
+
+      int v = pickBranch();
+      if (v < 0) return SAT;
+
+      totalDecisions++;
+      trailLimits.push_back(trail.size());
+      enqueue(2 * v + !phase[v], -1);
+    }
+  }
+}
+
+void CDCL::enqueue(int lit, int from) {
+  int v = lit >> 1;
+  values[v] = !(lit & 1);
+  level[v] = decisionLevel();
+  reason[v] = from;
+  trail.push_back(lit);
+}
+
+int CDCL::propagate() {
+  while (propagated < trail.size()) {
+    int falseLit = trail[propagated++] ^ 1;
+    totalPropagations++;
+
+    std::vector<int>& watching = watches[falseLit];
+    size_t i = 0, j = 0;
+    while (i < watching.size()) {
+      int c = watching[i++];
+      std::vector<int>& lits = clauses[c];
+
+      // The false literal goes second, the clause is done if the other
+      // watched literal is true
+      if (lits[0] == falseLit) std::swap(lits[0], lits[1]);
+      if (litValue(lits[0]) == 1) {
+        watching[j++] = c;
+        continue;
+      }
+
+      // Watch another literal that is not false
+      bool moved = false;
+      for (size_t k = 2; k < lits.size(); k++) {
+        if (litValue(lits[k]) != 0) {
+          std::swap(lits[1], lits[k]);
+          watches[lits[1]].push_back(c);
+          moved = true;
+          break;
+        }
+      }
+      if (moved) continue;
+
+      // Unit or conflict
+      watching[j++] = c;
+      if (litValue(lits[0]) == 0) {
+        while (i < watching.size()) watching[j++] = watching[i++];
+        watching.resize(j);
+        propagated = trail.size();
+        return c;
+      }
+      enqueue(lits[0], c);
+    }
+    watching.resize(j);
+  }
+  return -1;
+}
+
+int CDCL::analyze(int conflict, std::vector<int>& learnt) {
+  // First UIP: resolve the conflict with the reasons of the literals of the
+  // current level, from the end of the trail, until only one is left
+  learnt.assign(1, -1);
+  int pending = 0;
+  int lit = -1;
+  int index = trail.size() - 1;
+  int c = conflict;
+
+  do {
+    const std::vector<int>& lits = clauses[c];
+    // The implied literal of a reason is its first one
+    for (size_t k = lit < 0 ? 0 : 1; k < lits.size(); k++) {
+      int v = lits[k] >> 1;
+      if (seen[v] || level[v] == 0) continue;
+
+      seen[v] = 1;
+      bumpVariable(v);
+      if (level[v] >= decisionLevel())
+        pending++;
+      else
+        learnt.push_back(lits[k]);
+    }
+
+    while (!seen[trail[index] >> 1]) index--;
+    lit = trail[index--];
+    c = reason[lit >> 1];
+    seen[lit >> 1] = 0;
+    pending--;
+  } while (pending > 0);
+  learnt[0] = lit ^ 1;
+
+  // Drop the literals implied by the rest of the clause: every other literal
+  // of their reason is in the clause or fixed at level 0
+  marked.assign(learnt.begin() + 1, learnt.end());
+  size_t kept = 1;
+  for (size_t k = 1; k < learnt.size(); k++) {
+    int from = reason[learnt[k] >> 1];
+    bool implied = from >= 0;
+    if (implied) {
+      const std::vector<int>& lits = clauses[from];
+      for (size_t r = 1; r < lits.size() && implied; r++) {
+        int v = lits[r] >> 1;
+        implied = seen[v] || level[v] == 0;
+      }
+    }
+    if (!implied) learnt[kept++] = learnt[k];
+  }
+  learnt.resize(kept);
+  for (int markedLit : marked) seen[markedLit >> 1] = 0;
+
+  // Backtrack to the second highest level of the clause, whose literal is
+  // watched together with the asserting one
+  int backtrackLevel = 0;
+  size_t second = 1;
+  for (size_t k = 1; k < learnt.size(); k++) {
+    if (level[learnt[k] >> 1] > backtrackLevel) {
+      backtrackLevel = level[learnt[k] >> 1];
+      second = k;
+    }
+  }
+  if (learnt.size() > 1) std::swap(learnt[1], learnt[second]);
+
+  return backtrackLevel;
+}
+
+void CDCL::backtrack(int toLevel) {
+  if (decisionLevel() <= toLevel) return;
+
+  for (int i = trail.size() - 1; i >= trailLimits[toLevel]; i--) {
+    int v = trail[i] >> 1;
+    phase[v] = values[v];
+    values[v] = -1;
+    reason[v] = -1;
+    heapInsert(v);
+  }
+  trail.resize(trailLimits[toLevel]);
+  trailLimits.resize(toLevel);
+  propagated = trail.size();
+}
+
+int CDCL::attach(const std::vector<int>& literals, int levels) {
+  int c = clauses.size();
+  clauses.push_back(literals);
+  lbd.push_back(levels);
+  if (levels > 0) learnts.push_back(c);
+  watches[literals[0]].push_back(c);
+  watches[literals[1]].push_back(c);
+  return c;
+}
+
+void CDCL::reduceLearnts() {
+  // Most levels first, then the oldest. Clauses with two levels (glue
+  // clauses) and the reasons of the current assignment are kept
+  std::sort(learnts.begin(), learnts.end(), [&](int a, int b) {
+    if (lbd[a] != lbd[b]) return lbd[a] > lbd[b];
+    return a < b;
+  });
+
+  size_t removable = learnts.size() / 2;
+  size_t kept = 0;
+  for (size_t i = 0; i < learnts.size(); i++) {
+    int c = learnts[i];
+    int v = clauses[c][0] >> 1;
+    bool locked = values[v] >= 0 && reason[v] == c;
+    if (i < removable && lbd[c] > 2 && !locked) {
+      std::vector<int>().swap(clauses[c]);
+      totalDeleted++;
+    } else {
+      learnts[kept++] = c;
+    }
+  }
+  learnts.resize(kept);
+  std::sort(learnts.begin(), learnts.end());
+
+  // The watched literals are still the first two of every clause left
+  for (std::vector<int>& watching : watches) watching.clear();
+  for (size_t c = 0; c < clauses.size(); c++) {
+    if (clauses[c].empty()) continue;
+    watches[clauses[c][0]].push_back(c);
+    watches[clauses[c][1]].push_back(c);
+  }
+}
+
+int CDCL::pickBranch() {
+  while (!heap.empty()) {
+    int v = heap[0];
+    heap[0] = heap.back();
+    heapPosition[heap[0]] = 0;
+    heap.pop_back();
+    heapPosition[v] = -1;
+    if (!heap.empty()) heapDown(0);
+
+    if (values[v] < 0) return v;
+  }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+// VSIDS heap
+// -----------------------------------------------------------------------------
+void CDCL::bumpVariable(int v) {
+  activity[v] += varIncrement;
+
+  // Rescale before the activities overflow. The order does not change
+  if (activity[v] > 1e100) {
+    for (double& a : activity) a *= 1e-100;
+    varIncrement *= 1e-100;
+  }
+
+  if (heapPosition[v] >= 0) heapUp(heapPosition[v]);
+}
+
+bool CDCL::heapBefore(int a, int b) const {
+  if (activity[a] != activity[b]) return activity[a] > activity[b];
+  return a < b;
+}
+
+void CDCL::heapInsert(int v) {
+  if (heapPosition[v] >= 0) return;
+  heap.push_back(v);
+  heapPosition[v] = heap.size() - 1;
+  heapUp(heap.size() - 1);
+}
+
+void CDCL::heapUp(int i) {
+  int v = heap[i];
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!heapBefore(v, heap[parent])) break;
+    heap[i] = heap[parent];
+    heapPosition[heap[i]] = i;
+    i = parent;
+  }
+  heap[i] = v;
+  heapPosition[v] = i;
+}
+
+void CDCL::heapDown(int i) {
+  int v = heap[i];
+  int size = heap.size();
+  while (2 * i + 1 < size) {
+    int child = 2 * i + 1;
+    if (child + 1 < size && heapBefore(heap[child + 1], heap[child])) child++;
+    if (!heapBefore(heap[child], v)) break;
+    heap[i] = heap[child];
+    heapPosition[heap[i]] = i;
+    i = child;
+  }
+  heap[i] = v;
+  heapPosition[v] = i;
+}
+
+}  // namespace sat
@@ -0,0 +1,68 @@
+#include <algorithm>
+
+// Project headers
+#include <Communities.hpp>
+
+namespace sat {
+
+std::vector<int> DetectCommunities(FactorGraph* fg, int maxRounds) {
+  const int N = fg->variables.size();
+  std::vector<int> label(N);
+  for (int v = 0; v < N; v++) label[v] = v;
+
+  // Neighbour label counts, reset through the list of touched labels
+  std::vector<int> counts(N, 0);
+  std::vector<int> touched;
+
+  for (int round = 0; round < maxRounds; round++) {
+    bool changed = false;
+
+    for (Variable* var : fg->variables) {
+      if (var->assigned) continue;
+      const int v = var->id - 1;
+
+      for (Edge* edge : var->allNeighbourEdges) {
+        if (!edge->enabled) continue;
+        for (Edge* neighbour : edge->clause->allNeighbourEdges) {
+          if (!neighbour->enabled || neighbour->variable == var) continue;
+          int l = label[neighbour->variable->id - 1];
+          if (counts[l]++ == 0) touched.push_back(l);
+        }
+      }
+
+      // Most frequent label. Keep the current one on ties to avoid
+      // oscillations, otherwise take the smallest
+      int best = label[v];
+      int bestCount = counts[best];
+      for (int l : touched) {
+        bool better = counts[l] > bestCount;
+        bool tie = counts[l] == bestCount && best != label[v] && l < best;
+        if (better || tie) {
+          best = l;
+          bestCount = counts[l];
+        }
+      }
+      for (int l : touched) counts[l] = 0;
+      touched.clear();
+
+      if (best != label[v]) {
+        label[v] = best;
+        changed = true;
+      }
+    }
+
+    if (!changed) break;
+  }
+
+  // Number communities from 0 in order of appearance
+  std::vector<int> id(N, -1);
+  int totalCommunities = 0;
+  for (int v = 0; v < N; v++) {
+    if (id[label[v]] < 0) id[label[v]] = totalCommunities++;
+    label[v] = id[label[v]];
+  }
+
+  return label;
+}
+
+}  // namespace sat
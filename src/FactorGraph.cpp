@@ -11,7 +11,8 @@ namespace sat {
 // =============================================================================
 // Variable class
 // =============================================================================
-Variable::Variable(const unsigned id) : id(id), assigned(false) {}
+Variable::Variable(const unsigned id)
+    : id(id), assigned(false), value(false) {}
 
 std::vector<Edge*> Variable::GetEnabledEdges() {
   std::vector<Edge*> enabledNeigbours;
@@ -26,6 +27,8 @@ void Variable::AssignValue(const bool newValue) {
   assigned = true;
 }
 
+void Variable::UnassignValue() { assigned = false; }
+
 std::ostream& operator<<(std::ostream& os, const Variable* var) {
   os << "X" << var->id << ": "
      << (var->assigned ? (var->value ? "true" : "false") : "NOT_ASSIGNED");
@@ -53,6 +56,13 @@ void Clause::Dissable() {
   }
 }
 
+void Clause::UpdateState() {
+  enabled = !IsSAT();
+  for (Edge* edge : allNeighbourEdges) {
+    edge->enabled = enabled && !edge->variable->assigned;
+  }
+}
+
 int Clause::countTrueLiterals() {
   trueLiterals = 0;
   for (Edge* edge : allNeighbourEdges) {
@@ -96,6 +106,18 @@ std::ostream& operator<<(std::ostream& os, const Edge* e) {
   return os;
 }
 
+// =============================================================================
+// AssignmentStep class
+// =============================================================================
+void AssignmentStep::Revert() {
+  for (Variable* var : variables) var->UnassignValue();
+
+  for (Variable* var : variables) {
+    for (Edge* edge : var->allNeighbourEdges) edge->clause->UpdateState();
+  }
+  variables.clear();
+}
+
 // =============================================================================
 // FactorGraph class
 // =============================================================================
@@ -131,9 +153,10 @@ FactorGraph::FactorGraph(std::ifstream& file) {
       unsigned int totalClauses = stoi(tokens[3]);
 
       // Create variables
+      variableStorage.reserve(totalVariables);
       for (unsigned i = 0; i < totalVariables; i++) {
-        Variable* variable = new Variable(i + 1);
-        variables.push_back(variable);
+        variableStorage.emplace_back(i + 1);
+        variables.push_back(&variableStorage.back());
       }
 
       // Create clauses
@@ -169,6 +192,20 @@ FactorGraph::FactorGraph(std::ifstream& file) {
           }
         }
 
+        // Length class of the clause
+        if (currentClauseIndex < (int)clauses.size()) {
+          Clause* clause = clauses[currentClauseIndex];
+          size_t length = clause->allNeighbourEdges.size();
+          if (length == 2)
+            clause->bucket = BINARY_CLAUSE;
+          else if (length == 3)
+            clause->bucket = TERNARY_CLAUSE;
+          else if (length == 4)
+            clause->bucket = QUATERNARY_CLAUSE;
+          else if (length > LONG_CLAUSE_LENGTH)
+            clause->bucket = LONG_CLAUSE;
+        }
+
         // Next clause
         currentClauseIndex += 1;
       }
@@ -176,9 +213,53 @@ FactorGraph::FactorGraph(std::ifstream& file) {
   }
 }
 
+FactorGraph::FactorGraph(const FactorGraph& other) {
+  variableStorage.reserve(other.variables.size());
+  for (const Variable* var : other.variables) {
+    variableStorage.emplace_back(var->id);
+    variables.push_back(&variableStorage.back());
+  }
+
+  for (const Clause* clause : other.clauses) {
+    Clause* copy = new Clause(clause->id);
+    copy->bucket = clause->bucket;
+    clauses.push_back(copy);
+  }
+
+  // Edges are added to their nodes in the same order as in the other graph
+  for (const Edge* edge : other.edges) {
+    Clause* clause = clauses[edge->clause->id - 1];
+    Variable* variable = variables[edge->variable->id - 1];
+    Edge* copy = new Edge(edge->type, clause, variable);
+    edges.push_back(copy);
+    clause->allNeighbourEdges.push_back(copy);
+    variable->allNeighbourEdges.push_back(copy);
+  }
+
+  CopyState(&other);
+}
+
+void FactorGraph::CopyState(const FactorGraph* other) {
+  for (size_t v = 0; v < variables.size(); v++) {
+    const Variable* source = other->variables[v];
+    Variable* var = variables[v];
+    var->assigned = source->assigned;
+    var->value = source->value;
+  }
+
+  for (size_t c = 0; c < clauses.size(); c++) {
+    clauses[c]->enabled = other->clauses[c]->enabled;
+    clauses[c]->trueLiterals = other->clauses[c]->trueLiterals;
+  }
+
+  for (size_t e = 0; e < edges.size(); e++) {
+    edges[e]->enabled = other->edges[e]->enabled;
+    edges[e]->survey = other->edges[e]->survey;
+  }
+}
+
 FactorGraph::~FactorGraph() {
   for (Clause* clause : clauses) delete clause;
-  for (Variable* variable : variables) delete variable;
   for (Edge* edge : edges) delete edge;
 }
 
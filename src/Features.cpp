@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cmath>
+
+// Project headers
+#include <Communities.hpp>
+#include <Features.hpp>
+
+namespace sat {
+
+InstanceFeatures ExtractFeatures(FactorGraph* fg, bool withModularity) {
+  InstanceFeatures features;
+
+  // Degrees and polarity, from the variables
+  long long sumDegree2 = 0;
+  int positive = 0;
+  double sumImbalance = 0.0;
+  for (Variable* var : fg->variables) {
+    if (var->assigned) continue;
+    int p = 0, n = 0;
+    for (Edge* edge : var->allNeighbourEdges) {
+      if (!edge->enabled) continue;
+      if (edge->type)
+        p++;
+      else
+        n++;
+    }
+    features.variables++;
+    sumDegree2 += (long long)(p + n) * (p + n);
+    positive += p;
+    if (p + n > 0) sumImbalance += (double)std::abs(p - n) / (p + n);
+  }
+
+  // Lengths, from the clauses
+  long long sumLength2 = 0;
+  for (Clause* clause : fg->clauses) {
+    if (!clause->enabled) continue;
+    int length = 0;
+    for (Edge* edge : clause->allNeighbourEdges) length += edge->enabled;
+    features.clauses++;
+    features.literals += length;
+    sumLength2 += (long long)length * length;
+  }
+
+  auto deviation = [](double sum2, double mean, int count) {
+    return std::sqrt(std::max(0.0, sum2 / count - mean * mean));
+  };
+  if (features.variables > 0) {
+    features.degreeMean = (double)features.literals / features.variables;
+    features.degreeStd =
+        deviation(sumDegree2, features.degreeMean, features.variables);
+    features.polarityImbalance = sumImbalance / features.variables;
+    features.ratio = (double)features.clauses / features.variables;
+  }
+  if (features.clauses > 0) {
+    features.clauseLengthMean = (double)features.literals / features.clauses;
+    features.clauseLengthStd =
+        deviation(sumLength2, features.clauseLengthMean, features.clauses);
+    features.positiveFraction = (double)positive / features.literals;
+  }
+  features.threshold = RandomKSATThreshold(features.clauseLengthMean);
+  features.relativeDensity = features.ratio / features.threshold;
+
+  if (!withModularity || features.clauses == 0) return features;
+
+  // ---------------------------------------------------------------------------
+  // Modularity. Every variable of a clause of length k has weight 1 in it
+  // (k - 1 pairs), so the strength of a variable is its degree and the total
+  // weight is half the literals. Strengths are summed by community. Unit
+  // clauses link nothing
+  // ---------------------------------------------------------------------------
+  std::vector<int> community = DetectCommunities(fg);
+  std::vector<double> communityStrength(fg->variables.size(), 0.0);
+  double totalWeight = 0.0;
+  double inside = 0.0;
+  std::vector<int> labels;
+  for (Clause* clause : fg->clauses) {
+    if (!clause->enabled) continue;
+    labels.clear();
+    for (Edge* edge : clause->allNeighbourEdges) {
+      if (edge->enabled) labels.push_back(community[edge->variable->id - 1]);
+    }
+    const int k = labels.size();
+    if (k < 2) continue;
+    for (int l : labels) communityStrength[l] += 1.0;
+    totalWeight += k / 2.0;
+
+    // Pairs inside the same community, counted in runs of equal labels
+    std::sort(labels.begin(), labels.end());
+    int pairs = 0;
+    for (int i = 0, j = 0; i < k; i = j) {
+      while (j < k && labels[j] == labels[i]) j++;
+      pairs += (j - i) * (j - i - 1) / 2;
+    }
+    inside += (double)pairs / (k - 1);
+  }
+  if (totalWeight == 0.0) return features;
+
+  features.modularity = inside / totalWeight;
+  for (double s : communityStrength) {
+    double fraction = s / (2.0 * totalWeight);
+    features.modularity -= fraction * fraction;
+  }
+  return features;
+}
+
+double RandomKSATThreshold(double k) {
+  static const double known[] = {1.0, 4.267, 9.931, 21.117, 43.37, 87.79};
+  if (k <= 2.0) return known[0];
+  if (k <= 7.0) {
+    int i = std::min((int)k - 2, 4);
+    double t = k - 2 - i;
+    return known[i] + t * (known[i + 1] - known[i]);
+  }
+  return std::pow(2.0, k) * std::log(2.0) - (1.0 + std::log(2.0)) / 2.0;
+}
+
+}  // namespace sat
@@ -0,0 +1,497 @@
+#include <cmath>
+#include <vector>
+
+// Project headers
+#include <BatchSurveyPropagation.hpp>
+#include <Kernels.hpp>
+#include <Solver.hpp>
+
+// Implementations are inlined into every variant so each copy is compiled with
+// the instruction set of its wrapper
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+namespace sat {
+
+// =============================================================================
+// Kernel implementations
+// =============================================================================
+KERNEL_INLINE void computeSubProductsImpl(Variable* var) {
+  var->p = 1.0;
+  var->m = 1.0;
+  var->pzero = 0;
+  var->mzero = 0;
+
+  // For each edge connecting the variable to a clause
+  for (Edge* edge : var->allNeighbourEdges) {
+    if (edge->enabled) {
+      // If edge is negative update positive subproduct of variable
+      if (!edge->type) {
+        // If edge survey != 1
+        if (1.0 - edge->survey > ZERO_EPSILON) {
+          var->p *= 1.0 - edge->survey;
+        }
+        // If edge survey == 1
+        else
+          var->pzero++;
+      }
+      // If edge is positive, update negative subproduct of variable
+      else {
+        // If edge survey != 1
+        if (1.0 - edge->survey > ZERO_EPSILON) {
+          var->m *= 1.0 - edge->survey;
+        }
+        // If edge survey == 1
+        else
+          var->mzero++;
+      }
+    }
+  }
+}
+
+// Update the subproduct of the variable of the edge (p for negated edges, m
+// for positive ones) when the survey of the edge changes to newSurvey
+KERNEL_INLINE void updateSubProduct(Edge* edge, double newSurvey) {
+  Variable* var = edge->variable;
+  double& product = edge->type ? var->m : var->p;
+  int& zeros = edge->type ? var->mzero : var->pzero;
+
+  // If previous survey != 1 (with an epsilon margin)
+  if (1.0 - edge->survey > ZERO_EPSILON) {
+    // If new survey != 1, update the sub product with the difference
+    if (1.0 - newSurvey > ZERO_EPSILON)
+      product *= ((1.0 - newSurvey) / (1.0 - edge->survey));
+    // If new survey == 1, update the subproduct by remove the old survey
+    // and keep track of the new survey == 1 (zeros++)
+    else {
+      product /= (1.0 - edge->survey);
+      zeros++;
+    }
+  }
+  // If previous survey == 1
+  else {
+    // If new survey == 1, don't do anything (both surveys are the same)
+    // If new survey != 1, update subproduct
+    if (1.0 - newSurvey > ZERO_EPSILON) {
+      product *= (1.0 - newSurvey);
+      zeros--;
+    }
+  }
+}
+
+// Sub survey of an edge: probability that its variable is forced to violate
+// the clause. same is the cavity product of the clauses where the variable has
+// the same sign and opposite the product of the other sign.
+// SP and BP share the update. BP drops the term of the variable being
+// undecided (joker state), so the weight of not warning is not multiplied by
+// the probability of the opposite side being unconstrained.
+template <bool BP>
+KERNEL_INLINE double subSurvey(double same, double opposite) {
+  const double wn = BP ? same : same * (1.0 - opposite);
+  const double wt = opposite;
+  return wn / (wn + wt);
+}
+
+// Gather the cavity products of an edge (see subSurvey)
+KERNEL_INLINE void gatherProducts(const Edge* edge, double& same,
+                                  double& opposite) {
+  const Variable* var = edge->variable;
+  const double sameProduct = edge->type ? var->m : var->p;
+  const int sameZeros = edge->type ? var->mzero : var->pzero;
+  const int oppositeZeros = edge->type ? var->pzero : var->mzero;
+
+  // Remove this edge from the product of its side
+  if (sameZeros == 0)
+    same = sameProduct / (1.0 - edge->survey);
+  else if (sameZeros == 1 && (1.0 - edge->survey) < ZERO_EPSILON)
+    same = sameProduct;
+  else
+    same = 0.0;
+
+  opposite = oppositeZeros ? 0.0 : (edge->type ? var->p : var->m);
+}
+
+// Kernel for clauses of exactly K literals. Loops have a fixed trip count and
+// are fully unrolled; disabled literals get a sub survey of 1 (neutral in the
+// products) and are not updated, which gives the same result as the generic
+// kernel.
+template <int K, bool BP>
+KERNEL_INLINE double updateSurveysFixedImpl(Clause* clause) {
+  Edge* const* edges = clause->allNeighbourEdges.data();
+  bool active[K];
+  double same[K], opposite[K], sub[K], prefix[K];
+
+  for (int i = 0; i < K; i++) {
+    active[i] = edges[i]->enabled && !edges[i]->variable->assigned;
+    if (active[i]) gatherProducts(edges[i], same[i], opposite[i]);
+  }
+
+  double product = 1.0;
+  for (int i = 0; i < K; i++) {
+    sub[i] = active[i] ? subSurvey<BP>(same[i], opposite[i]) : 1.0;
+    prefix[i] = product;
+    product *= sub[i];
+  }
+
+  double maxConvDiffInClause = 0.0;
+  double suffix = 1.0;
+  for (int i = K - 1; i >= 0; i--) {
+    const double newSurvey = prefix[i] * suffix;
+    suffix *= sub[i];
+    if (!active[i]) continue;
+
+    Edge* edge = edges[i];
+    updateSubProduct(edge, newSurvey);
+
+    // A NaN change is kept: the subproducts changed even if no survey moved
+    const double edgeConvDiff = std::abs(edge->survey - newSurvey);
+    if (maxConvDiffInClause < edgeConvDiff || edgeConvDiff != edgeConvDiff)
+      maxConvDiffInClause = edgeConvDiff;
+    edge->survey = newSurvey;
+  }
+
+  return maxConvDiffInClause;
+}
+
+// Kernel for clauses of any length. The survey of each edge is the product of
+// the sub surveys of the other literals, computed as prefix times suffix
+// products: no divisions and no special cases for sub surveys equal to 0, in
+// time linear in the length. Buffers are on the stack for medium clauses and
+// per thread on the heap for long ones.
+template <bool BP, bool LONG>
+KERNEL_INLINE double updateSurveysImpl(Clause* clause) {
+  Edge* stackEdges[LONG ? 1 : LONG_CLAUSE_LENGTH];
+  double stackBuffer[LONG ? 1 : 4 * LONG_CLAUSE_LENGTH];
+  Edge** edges = stackEdges;
+  double* buffer = stackBuffer;
+  size_t capacity = LONG_CLAUSE_LENGTH;
+  if (LONG) {
+    thread_local std::vector<Edge*> longEdges;
+    thread_local std::vector<double> longBuffer;
+    capacity = clause->allNeighbourEdges.size();
+    longEdges.resize(capacity);
+    longBuffer.resize(4 * capacity);
+    edges = longEdges.data();
+    buffer = longBuffer.data();
+  }
+  double* same = buffer;                  // Cavity product, same sign
+  double* opposite = buffer + capacity;   // Product, opposite sign
+  double* sub = buffer + 2 * capacity;    // Sub surveys
+  double* prefix = buffer + 3 * capacity; // Product of previous sub surveys
+
+  // ==========================================================
+  // Gather the subproducts of the variables of enabled edges
+  // ==========================================================
+  int n = 0;
+  for (Edge* edge : clause->allNeighbourEdges) {
+    if (edge->enabled && !edge->variable->assigned) {
+      gatherProducts(edge, same[n], opposite[n]);
+      edges[n++] = edge;
+    }
+  }
+
+  // ==========================================
+  // Sub surveys (independent, vectorizable)
+  // ==========================================
+  for (int i = 0; i < n; i++) sub[i] = subSurvey<BP>(same[i], opposite[i]);
+
+  double product = 1.0;
+  for (int i = 0; i < n; i++) {
+    prefix[i] = product;
+    product *= sub[i];
+  }
+
+  // ===============================================================
+  // New surveys (prefix times suffix) and update of the variables
+  // ===============================================================
+  double maxConvDiffInClause = 0.0;
+  double suffix = 1.0;
+  for (int i = n - 1; i >= 0; i--) {
+    const double newSurvey = prefix[i] * suffix;
+    suffix *= sub[i];
+
+    Edge* edge = edges[i];
+    updateSubProduct(edge, newSurvey);
+
+    // Store new survey and update max clause converge diff (NaN is kept)
+    const double edgeConvDiff = std::abs(edge->survey - newSurvey);
+    if (maxConvDiffInClause < edgeConvDiff || edgeConvDiff != edgeConvDiff)
+      maxConvDiffInClause = edgeConvDiff;
+    edge->survey = newSurvey;
+  }
+
+  return maxConvDiffInClause;
+}
+
+template <bool BP>
+KERNEL_INLINE void evaluateVarImpl(Variable* var) {
+  double p = var->pzero ? 0 : var->p;
+  double m = var->mzero ? 0 : var->m;
+
+  // BP marginals have no joker state: Hp (forced to false) is proportional
+  // to m and Hm (forced to true) to p
+  var->Hz = BP ? 0.0 : p * m;
+  var->Hp = m - var->Hz;
+  var->Hm = p - var->Hz;
+
+  // Normalize
+  double sum = var->Hm + var->Hz + var->Hp;
+  var->Hz /= sum;
+  var->Hp /= sum;
+  var->Hm /= sum;
+
+  // Store eval value
+  var->evalValue = std::abs(var->Hp - var->Hm);
+}
+
+// Biases of a list of variables in blocks: the subproducts are gathered in
+// small dense arrays so the arithmetic is vectorized, then the results are
+// stored back. The sum is accumulated in list order.
+template <bool BP>
+KERNEL_INLINE double evaluateVarsImpl(Variable* const* vars, int count) {
+  const int B = 64;
+  double p[B], m[B], hz[B], hp[B], hm[B];
+  double sumBias = 0.0;
+
+  for (int first = 0; first < count; first += B) {
+    const int n = count - first < B ? count - first : B;
+
+    for (int i = 0; i < n; i++) {
+      const Variable* var = vars[first + i];
+      p[i] = var->pzero ? 0 : var->p;
+      m[i] = var->mzero ? 0 : var->m;
+    }
+
+    // Same operations (and order) as evaluateVarImpl
+    for (int i = 0; i < n; i++) {
+      const double z = BP ? 0.0 : p[i] * m[i];
+      const double plus = m[i] - z;
+      const double minus = p[i] - z;
+      const double sum = minus + z + plus;
+      hz[i] = z / sum;
+      hp[i] = plus / sum;
+      hm[i] = minus / sum;
+    }
+
+    for (int i = 0; i < n; i++) {
+      Variable* var = vars[first + i];
+      var->Hz = hz[i];
+      var->Hp = hp[i];
+      var->Hm = hm[i];
+      var->evalValue = std::abs(hp[i] - hm[i]);
+
+      // BP has no joker state, its max bias is at least 1/2. The
+      // polarization tells instead if the marginals are informative
+      if (BP)
+        sumBias += var->evalValue;
+      else
+        sumBias += hp[i] > hm[i] ? hp[i] : hm[i];
+    }
+  }
+
+  return sumBias;
+}
+
+KERNEL_INLINE void sweepBatchImpl(SPBatchGroup* group, const int* order,
+                                  double* laneMaxDiff) {
+  const int W = SP_BATCH_LANES;
+  const int K = group->width;
+  const int* var = group->var.data();
+  const unsigned char* type = group->type.data();
+  double* survey = group->survey.data();
+  double* p = group->p.data();
+  double* m = group->m.data();
+  int* pzero = group->pzero.data();
+  int* mzero = group->mzero.data();
+
+  // Sub surveys and prefix/suffix products of the cavity
+  double* sub = group->scratch.data();
+  double* prefix = sub + (K + 1) * W;
+  double* suffix = prefix + (K + 1) * W;
+
+  for (int l = 0; l < W; l++) laneMaxDiff[l] = 0.0;
+
+  for (int o = 0; o < group->clauses; o++) {
+    const int base = order[o] * K * W;
+
+    // ---------------------------------------------------------------
+    // Sub survey of every literal, all lanes at once. Padding gives 1,
+    // the neutral element of the product
+    // ---------------------------------------------------------------
+    for (int j = 0; j < K; j++) {
+      for (int l = 0; l < W; l++) {
+        const int s = base + j * W + l;
+        const int v = var[s] * W + l;
+        const bool positive = type[s] == 1;
+
+        // Products of the clauses where the variable has the same sign as
+        // in this clause (without this one) and the opposite sign
+        const double same = positive ? m[v] : p[v];
+        const int sameZeros = positive ? mzero[v] : pzero[v];
+        const double opposite = (positive ? pzero[v] : mzero[v]) ? 0.0
+                                : positive                        ? p[v]
+                                                                  : m[v];
+
+        const double one = 1.0 - survey[s];
+        double cavity = 0.0;
+        if (sameZeros == 0)
+          cavity = same / one;
+        else if (sameZeros == 1 && one < ZERO_EPSILON)
+          cavity = same;
+
+        const double wn = cavity * (1.0 - opposite);
+        const double wt = opposite;
+        sub[j * W + l] = type[s] == 2 ? 1.0 : wn / (wn + wt);
+      }
+    }
+
+    // --------------------------------------------------------
+    // Cavity products without divisions: prefix times suffix
+    // --------------------------------------------------------
+    for (int l = 0; l < W; l++) {
+      prefix[l] = 1.0;
+      suffix[K * W + l] = 1.0;
+    }
+    for (int j = 0; j < K; j++) {
+      for (int l = 0; l < W; l++)
+        prefix[(j + 1) * W + l] = prefix[j * W + l] * sub[j * W + l];
+    }
+    for (int j = K - 1; j >= 0; j--) {
+      for (int l = 0; l < W; l++)
+        suffix[j * W + l] = suffix[(j + 1) * W + l] * sub[j * W + l];
+    }
+
+    // ----------------------------------------------------------
+    // Store the new surveys and update the variable subproducts
+    // ----------------------------------------------------------
+    for (int j = 0; j < K; j++) {
+      for (int l = 0; l < W; l++) {
+        const int s = base + j * W + l;
+        if (type[s] == 2 || group->done[l]) continue;
+
+        const int v = var[s] * W + l;
+        const double newSurvey = prefix[j * W + l] * suffix[(j + 1) * W + l];
+        double& product = type[s] ? m[v] : p[v];
+        int& zeros = type[s] ? mzero[v] : pzero[v];
+
+        if (1.0 - survey[s] > ZERO_EPSILON) {
+          if (1.0 - newSurvey > ZERO_EPSILON)
+            product *= (1.0 - newSurvey) / (1.0 - survey[s]);
+          else {
+            product /= 1.0 - survey[s];
+            zeros++;
+          }
+        } else if (1.0 - newSurvey > ZERO_EPSILON) {
+          product *= 1.0 - newSurvey;
+          zeros--;
+        }
+
+        const double diff = std::abs(survey[s] - newSurvey);
+        if (diff > laneMaxDiff[l]) laneMaxDiff[l] = diff;
+        survey[s] = newSurvey;
+      }
+    }
+  }
+}
+
+// =============================================================================
+// Variants
+//
+// One wrapper per instruction set around the same implementations
+// =============================================================================
+#define DEFINE_KERNELS(NAME, TARGET)                                  \
+  TARGET static void computeSubProducts_##NAME(Variable* var) {      \
+    computeSubProductsImpl(var);                                      \
+  }                                                                   \
+  TARGET static double updateBinary_##NAME(Clause* clause) {          \
+    return updateSurveysFixedImpl<2, false>(clause);                  \
+  }                                                                   \
+  TARGET static double updateTernary_##NAME(Clause* clause) {         \
+    return updateSurveysFixedImpl<3, false>(clause);                  \
+  }                                                                   \
+  TARGET static double updateQuaternary_##NAME(Clause* clause) {      \
+    return updateSurveysFixedImpl<4, false>(clause);                  \
+  }                                                                   \
+  TARGET static double updateMedium_##NAME(Clause* clause) {          \
+    return updateSurveysImpl<false, false>(clause);                   \
+  }                                                                   \
+  TARGET static double updateLong_##NAME(Clause* clause) {            \
+    return updateSurveysImpl<false, true>(clause);                    \
+  }                                                                   \
+  TARGET static void evaluateVar_##NAME(Variable* var) {              \
+    evaluateVarImpl<false>(var);                                      \
+  }                                                                   \
+  TARGET static double updateBinaryBP_##NAME(Clause* clause) {        \
+    return updateSurveysFixedImpl<2, true>(clause);                   \
+  }                                                                   \
+  TARGET static double updateTernaryBP_##NAME(Clause* clause) {       \
+    return updateSurveysFixedImpl<3, true>(clause);                   \
+  }                                                                   \
+  TARGET static double updateQuaternaryBP_##NAME(Clause* clause) {    \
+    return updateSurveysFixedImpl<4, true>(clause);                   \
+  }                                                                   \
+  TARGET static double updateMediumBP_##NAME(Clause* clause) {        \
+    return updateSurveysImpl<true, false>(clause);                    \
+  }                                                                   \
+  TARGET static double updateLongBP_##NAME(Clause* clause) {          \
+    return updateSurveysImpl<true, true>(clause);                     \
+  }                                                                   \
+  TARGET static void evaluateVarBP_##NAME(Variable* var) {            \
+    evaluateVarImpl<true>(var);                                       \
+  }                                                                   \
+  TARGET static double evaluateVars_##NAME(Variable* const* vars,      \
+                                          int count, bool bp) {       \
+    return bp ? evaluateVarsImpl<true>(vars, count)                   \
+              : evaluateVarsImpl<false>(vars, count);                 \
+  }                                                                   \
+  TARGET static void sweepBatch_##NAME(SPBatchGroup* group,           \
+                                       const int* order,              \
+                                       double* laneMaxDiff) {         \
+    sweepBatchImpl(group, order, laneMaxDiff);                        \
+  }                                                                   \
+  static const Kernels kernels_##NAME = {                             \
+      #NAME,                                                          \
+      computeSubProducts_##NAME,                                      \
+      {updateBinary_##NAME, updateTernary_##NAME,                     \
+       updateQuaternary_##NAME, updateMedium_##NAME,                  \
+       updateLong_##NAME},                                            \
+      evaluateVar_##NAME,                                             \
+      {updateBinaryBP_##NAME, updateTernaryBP_##NAME,                 \
+       updateQuaternaryBP_##NAME, updateMediumBP_##NAME,              \
+       updateLongBP_##NAME},                                          \
+      evaluateVarBP_##NAME,                                           \
+      evaluateVars_##NAME,                                            \
+      sweepBatch_##NAME};
+
+DEFINE_KERNELS(baseline, )
+
+#if defined(__x86_64__) || defined(__i386__)
+DEFINE_KERNELS(avx2, __attribute__((target("avx2,fma"))))
+DEFINE_KERNELS(avx512,
+               __attribute__((target("avx512f,avx512vl,avx512dq,avx2,fma"))))
+#endif
+
+// =============================================================================
+// Dispatch
+// =============================================================================
+const Kernels* SelectKernels() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx512dq"))
+    return &kernels_avx512;
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    return &kernels_avx2;
+#endif
+  return &kernels_baseline;
+}
+
+const Kernels* GetKernels(const std::string& name) {
+  if (name == "baseline") return &kernels_baseline;
+#if defined(__x86_64__) || defined(__i386__)
+  if (name == "avx2") return &kernels_avx2;
+  if (name == "avx512") return &kernels_avx512;
+#endif
+  return nullptr;
+}
+
+}  // namespace sat
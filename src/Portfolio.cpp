@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+// Project headers
+#include <Portfolio.hpp>
+#include <ThreadPool.hpp>
+
+namespace sat {
+
+// =============================================================================
+// Portfolio
+// =============================================================================
+PortfolioResult Portfolio::Run(FactorGraph* graph) {
+  PortfolioResult portfolio;
+  portfolio.results.assign(configs.size(), CANCELLED);
+  if (configs.empty()) return portfolio;
+
+  std::atomic<bool> solved(false);
+  std::mutex winnerMutex;
+
+  ThreadPool pool(std::max(1, std::min(numThreads, (int)configs.size())));
+  pool.Run(
+      configs.size(),
+      [&](int c, unsigned) {
+        if (solved) return;
+
+        FactorGraph copy(*graph);
+        int N = copy.variables.size();
+        Solver solver(N, (double)copy.clauses.size() / N, configs[c].seed);
+        if (setup) setup(solver);
+        solver.spSchedule = configs[c].schedule;
+        solver.cancel = &solved;
+
+        AlgorithmResult result = solver.SID(&copy, configs[c].fraction);
+        portfolio.results[c] = result;
+
+        // The first SAT configuration wins and stops the rest
+        if (result == SAT) {
+          std::lock_guard<std::mutex> lock(winnerMutex);
+          if (portfolio.winner < 0) {
+            portfolio.winner = c;
+            graph->CopyState(&copy);
+            solved = true;
+          }
+        }
+      },
+      false);
+
+  portfolio.result = portfolio.winner >= 0 ? SAT : portfolio.results[0];
+  return portfolio;
+}
+
+}  // namespace sat
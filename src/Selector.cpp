@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+// Project headers
+#include <Selector.hpp>
+
+namespace sat {
+
+const std::vector<SelectorRule>& DefaultSelectorTable() {
+  const double any = -1.0;
+  const double last = std::numeric_limits<double>::infinity();
+  static const std::vector<SelectorRule> table = {
+      // Community structure: SP converges inside the communities first
+      {0.97, 0.6, {SP_DECIMATION, 0.04, 1000, 0.001, COMMUNITY_SCHEDULE, 0}},
+      {last, 0.6, {SP_DECIMATION, 0.01, 1000, 0.001, COMMUNITY_SCHEDULE, 0}},
+      // Up to about 4.03 in 3-SAT local search alone is faster than any SP
+      {0.945, any, {LOCAL_SEARCH_ONLY, 0.04, 1000, 0.001, RANDOM_SCHEDULE, 50}},
+      // The batch shrinks close to the threshold (4.14 and 4.21 in 3-SAT)
+      {0.97, any, {SP_DECIMATION, 0.04, 1000, 0.001, RANDOM_SCHEDULE, 0}},
+      {0.986, any, {SP_DECIMATION, 0.01, 1000, 0.001, RANDOM_SCHEDULE, 0}},
+      {last, any, {SP_DECIMATION, 0.005, 1000, 0.001, RANDOM_SCHEDULE, 0}},
+  };
+  return table;
+}
+
+EngineChoice SelectEngine(const InstanceFeatures& features,
+                          const std::vector<SelectorRule>& table) {
+  if (table.empty()) return EngineChoice();
+  for (const SelectorRule& rule : table) {
+    if (features.relativeDensity < rule.maxRelativeDensity &&
+        features.modularity >= rule.minModularity)
+      return rule.choice;
+  }
+  return table.back().choice;
+}
+
+AlgorithmResult SolveWithChoice(Solver& solver, FactorGraph* graph,
+                                const EngineChoice& choice) {
+  solver.engine = choice.strategy == BP_DECIMATION ? BP_ENGINE : SP_ENGINE;
+  solver.spMaxIt = choice.spMaxIt;
+  solver.spEpsilon = choice.spEpsilon;
+  solver.spSchedule = choice.schedule;
+
+  if (choice.strategy == LOCAL_SEARCH_ONLY) {
+    int variables = graph->GetUnassignedVariables().size();
+    int maxFlips = solver.wsMaxFlips;
+    if (choice.wsFlipsPerVariable > 0)
+      solver.wsMaxFlips =
+          std::max(maxFlips, choice.wsFlipsPerVariable * variables);
+    auto start = std::chrono::steady_clock::now();
+    AlgorithmResult result = solver.LocalSearch(graph);
+    solver.wsMaxFlips = maxFlips;
+    if (result != INDETERMINATE) return result;
+
+    // SID gets what is left of the time budget
+    double budget = solver.timeBudget;
+    if (budget > 0.0) {
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (elapsed.count() >= budget) return TIMEOUT;
+      solver.timeBudget = budget - elapsed.count();
+    }
+    result = solver.SID(graph, choice.fraction);
+    solver.timeBudget = budget;
+    return result;
+  }
+
+  return solver.SID(graph, choice.fraction);
+}
+
+}  // namespace sat
@@ -1,5 +1,16 @@
+#include <CDCL.hpp>
+#include <Communities.hpp>
+#include <Features.hpp>
 #include <Solver.hpp>
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
 
 namespace sat {
 
@@ -12,59 +23,182 @@ Solver::Solver(int N, double a, int seed)
       randomReal01UD(0, 1),
       N(N),
       alpha(a),
-      wsMaxFlips(100 * N) {
+      wsMaxFlips(100 * N),
+      kernels(SelectKernels()) {
   // Random number generator initialization
   if (seed == 0) initialSeed = rd();
   randomGenerator.seed(initialSeed);
 }
 
+ThreadPool* Solver::getPool() {
+  unsigned size = numThreads > 1 ? numThreads : 1;
+  if (!pool || pool->size() != size) pool.reset(new ThreadPool(size));
+  return pool.get();
+}
+
+void Solver::startBudget() {
+  deadline = chrono::steady_clock::now() +
+             chrono::duration_cast<chrono::steady_clock::duration>(
+                 chrono::duration<double>(timeBudget));
+  bestSatisfiedClauses = 0;
+}
+
 // =============================================================================
 // Algorithms
 // =============================================================================
 AlgorithmResult Solver::SID(FactorGraph* graph, double fraction) {
   fg = graph;
   sidFraction = fraction;
+  startBudget();
   totalSPIterations = 0;
+  totalSPLocalSweeps = 0;
   totalSIDIterations = 0;
+  totalEarlyFixed = 0;
+
+  int baseAssign =
+      sidSelectionSize > 0 ? sidSelectionSize : (int)(N * fraction);
+  if (baseAssign < 1) baseAssign = 1;
 
-  int assignFraction = (int)(N * fraction);
-  if (assignFraction < 1) assignFraction = 1;
+  // Adaptive schedule: the batch is baseAssign times a scale between 1 and
+  // sidMaxFraction / fraction
+  SIDProgress progress = {1.0, 0, 0, baseAssign, 0, 0, 0};
+  double maxBatchScale = max(1.0, sidMaxFraction / fraction);
 
   // --------------------------------
   // Random initialization of surveys
   // --------------------------------
-  for (Edge* edge : fg->edges) {
-    edge->survey = getRandomReal01();
+  if (!sidKeepSurveys) {
+    for (Edge* edge : fg->edges) {
+      edge->survey = getRandomReal01();
+    }
+  }
+
+  // Communities are detected once, decimation only removes variables
+  if (spSchedule == COMMUNITY_SCHEDULE) communities = DetectCommunities(fg);
+
+  // Decisions are recorded in the trail when they may be undone
+  recordTrail = sidBacktracking || sidProbing || sidMaxRetries > 0 ||
+                sidMaxRestarts > 0;
+  trail.clear();
+  decisionStep.assign(fg->variables.size(), -1);
+  unfixedValue.assign(fg->variables.size(), -1);
+  totalUnfixed = 0;
+  totalRefixedOpposite = 0;
+  totalRetries = 0;
+  totalRestarts = 0;
+  totalConflicts = 0;
+  totalFailedLiterals = 0;
+  totalBatchFallbacks = 0;
+  totalResidualSwitches = 0;
+  if (sidBatchFixing && claimsSize != fg->variables.size()) {
+    claimsSize = fg->variables.size();
+    claims.reset(new atomic<unsigned char>[claimsSize]);
+    for (size_t v = 0; v < claimsSize; v++) claims[v] = 0;
+  }
+
+  // The last decimation step is undone by a restart together with the steps
+  // fixed early by SP after it
+  convergedSurveys.clear();
+
+  // Every unassigned variable is evaluated and queued after the first SP call
+  if (sidIncrementalBiases) resetBiasQueue();
+
+  if (!resumePath.empty()) {
+    // The checkpoint replaces the state initialized above
+    string path = resumePath;
+    resumePath.clear();
+    if (!readCheckpoint(path, progress)) {
+      cout << "ERROR: Can't read checkpoint " << path << endl;
+      return INDETERMINATE;
+    }
+  } else {
+    // Decisions of a branch of the tree search
+    for (const pair<unsigned, bool>& decision : sidInitialDecisions) {
+      Variable* var = fg->variables[decision.first - 1];
+      if (var->assigned && var->value == decision.second) continue;
+      if (!decideVariable(var, decision.second)) return CONTRADICTION;
+    }
   }
 
   // Run until sat, sp unconverge or wlaksat result
   while (true) {
+    if (cancelled()) return CANCELLED;
+    if (timedOut()) return timeout();
+    if (sidCheckpointSteps > 0 && totalSIDIterations > 0 &&
+        totalSIDIterations % sidCheckpointSteps == 0 &&
+        !writeCheckpoint(progress))
+      cout << "ERROR: Can't write checkpoint " << sidCheckpointPath << endl;
     totalSIDIterations++;
+
+    // Small or sparse residual, solved without more SP calls
+    if (residualIsCheap(progress)) {
+      totalResidualSwitches++;
+      vector<Variable*> residual = fg->GetUnassignedVariables();
+      cout << "Switching to the residual solver" << endl;
+      AlgorithmResult result = solveResidual();
+      if (result != INDETERMINATE) return result;
+
+      // Walksat leaves its last assignment in the residual variables
+      for (Variable* var : residual) var->UnassignValue();
+      progress.failedResidual = residual.size();
+    }
+
     // ----------------------------
-    // Run SP
+    // Run SP (or BP, both share the graph and the schedules)
     // If trivial state is reach, walksat is called and the result returned
     // ----------------------------
+    int previousSPIterations = totalSPIterations;
+    spWarmStart = totalSIDIterations > 1;
     AlgorithmResult spResult = surveyPropagation();
     if (spResult == WALKSAT) cout << fg << endl;
+    if (spResult == TIMEOUT) return timeout();
+
+    // Restart from the last converged state with the surveys around the undone
+    // variables reseeded, and a smaller batch
+    if (spResult == UNCONVERGE && totalRestarts < sidMaxRestarts) {
+      totalRestarts++;
+      restartFromConverged(progress.lastStepStart);
+      progress.retryBatch = max(1, progress.lastBatch / 2);
+      continue;
+    }
+
+    // Both values of a variable fixed early failed: undo the last decimation
+    // step and the variables fixed since, then try with half the batch
+    if (spResult == CONTRADICTION && totalRetries < sidMaxRetries) {
+      totalRetries++;
+      for (size_t step = trail.size(); step-- > progress.lastStepStart;) {
+        revertStep(step);
+      }
+      trail.resize(progress.lastStepStart);
+      progress.retryBatch = max(1, progress.lastBatch / 2);
+      continue;
+    }
     if (spResult != CONVERGE) return spResult;
+    if (sidMaxRestarts > 0) {
+      convergedSurveys.resize(fg->edges.size());
+      for (size_t e = 0; e < fg->edges.size(); e++)
+        convergedSurveys[e] = fg->edges[e]->survey;
+    }
 
     // --------------------------------
     // Build variable list and order it
     // --------------------------------
     vector<Variable*> unassignedVariables;
-
-    // Evaluate and store the sum of the max bias of all unassigned variables
-    double sumMaxBias = 0.0;
-    for (Variable* var : fg->variables) {
-      if (!var->assigned) {
-        evaluateVar(var);
-        // printf("X%d H.p:%f - H.m:%f\n", var->id, var->Hp, var->Hm);
-        // cout << "X" << var->id << " H.p:" << var->Hp << " - H.m:" << var->Hm
-        // << endl;
-        double maxBias = var->Hp > var->Hm ? var->Hp : var->Hm;
-        sumMaxBias += maxBias;
-        unassignedVariables.push_back(var);
-      }
+    double sumMaxBias;
+    size_t totalUnassigned;
+    if (sidIncrementalBiases) {
+      // The queue holds all the unassigned variables with their bias
+      sumMaxBias = updateBiasQueue();
+      totalUnassigned = biasQueue.size();
+    } else {
+      unassignedVariables = fg->GetUnassignedVariables();
+      totalUnassigned = unassignedVariables.size();
+
+      // Evaluate and store the sum of the max bias of all unassigned
+      // variables (already done if the biases were fused with the last SP
+      // sweep)
+      sumMaxBias = fusedBiasesReady ? fusedSumMaxBias
+                                    : evaluateVars(unassignedVariables);
     }
 
     // int prevUnsassignedVars = unassignedVariables.size();
@@ -75,52 +209,191 @@ AlgorithmResult Solver::SID(FactorGraph* graph, double fraction) {
     // Check paramagnetic state
     // TODO: Entender que significa esto, en el codigo original, este es
     // el unico sitio donde se llama a walksat
-    if (sumMaxBias / unassignedVariables.size() < paramagneticState) {
+    if (sumMaxBias / totalUnassigned < paramagneticState) {
       cout << "Paramagnetic state reached" << endl;
       // cout << fg << endl;
-      return walksat();
+      return solveResidual();
     }
 
-    // Assign minimum 1 variable
-    sort(unassignedVariables.begin(), unassignedVariables.end(),
-         [](const Variable* lvar, const Variable* rvar) {
-           return std::abs(lvar->evalValue) > std::abs(rvar->evalValue);
-         });
-
-    // cout << unassignedVariables[0]->id << ": "
-    //      << unassignedVariables[0]->evalValue << ", "
-    //      << unassignedVariables[1]->id << ": "
-    //      << unassignedVariables[1]->evalValue << ", "
-    //      << unassignedVariables[2]->id << ": "
-    //      << unassignedVariables[2]->evalValue << endl;
+    // -------------------------------------------------------------------------
+    // Backtracking: unfix the decisions that SP does not support anymore. The
+    // biases of the unfixed variables come from the surveys they had when
+    // they were fixed, so SP runs again on the graph with their clauses
+    // enabled before the next batch is chosen
+    // -------------------------------------------------------------------------
+    if (sidBacktracking && !progress.unfixedLast &&
+        (bspMaxUnfixed <= 0 || totalUnfixed < bspMaxUnfixed)) {
+      int batch = max(1, (int)(baseAssign * progress.batchScale));
+      if (progress.retryBatch > 0) batch = min(batch, progress.retryBatch);
+      if (unfixVariables((int)(batch * bspRatio)) > 0) {
+        progress.unfixedLast = 1;
+        continue;
+      }
+    }
+    progress.unfixedLast = 0;
+
+    // -------------------------------------------------------------------------
+    // Size of the batch. With the adaptive schedule it grows while SP
+    // converges fast and the biases are strongly polarised, and shrinks back
+    // when SP slows down or the polarisation drops
+    // -------------------------------------------------------------------------
+    if (sidAdaptiveFraction) {
+      int sweeps = totalSPIterations - previousSPIterations;
+      double meanMaxBias = sumMaxBias / totalUnassigned;
+      if (sweeps <= sidFastSweeps && meanMaxBias >= sidPolarizedBias)
+        progress.batchScale = min(progress.batchScale * 2.0, maxBatchScale);
+      else if (sweeps > sidSlowSweeps || meanMaxBias < sidPolarizedBias)
+        progress.batchScale = max(progress.batchScale / 2.0, 1.0);
+    }
+    int assignFraction = max(1, (int)(baseAssign * progress.batchScale));
+    if (progress.retryBatch > 0)
+      assignFraction = min(assignFraction, progress.retryBatch);
+
+    // Alternatives to this step for the tree search
+    if (onBranch && sidBranchGap > 0.0) branchDecimation(assignFraction);
+
+    // Next variable in decimation order. Without the queue only the first
+    // assignFraction variables of the list are selected instead of sorting
+    // the whole list, and more are selected if UP already assigned some of
+    // them
+    size_t next = 0, selected = 0;
+    auto nextVariable = [&]() -> Variable* {
+      if (sidIncrementalBiases) {
+        if (biasQueue.empty()) return nullptr;
+        Variable* var = biasQueue.Top();
+        forgetBias(var);
+        return var;
+      }
+      if (next == selected)
+        selected +=
+            SelectVariables(unassignedVariables, selected, assignFraction);
+      return next < selected ? unassignedVariables[next++] : nullptr;
+    };
 
     // ------------------------
     // Fix the set of variables
     // ------------------------
     // int assignFraction = (int)(unassignedVariables.size() * fraction);
     // if (assignFraction < 1) assignFraction = 1;
-    int auxAssign = assignFraction;
-    for (int i = 0; i < auxAssign; i++) {
+    int fixedVariables = 0;
+    size_t stepStart = trail.size();
+    progress.lastStepStart = stepStart;
+    progress.lastBatch = assignFraction;
+    bool rolledBack = false;
+
+    // Both values of a variable fail: undo the whole step and run SP again
+    // before trying with half the batch
+    auto rollBackStep = [&]() {
+      for (size_t step = trail.size(); step-- > stepStart;) {
+        revertStep(step);
+      }
+      trail.resize(stepStart);
+      progress.retryBatch = max(1, assignFraction / 2);
+      rolledBack = true;
+    };
+
+    // Batch fixing: the step is done if the batch propagates without conflict,
+    // otherwise its variables are fixed one at a time first
+    vector<Variable*> batch;
+    size_t batchNext = 0;
+    if (sidBatchFixing || sidProbing) {
+      while ((int)batch.size() < assignFraction) {
+        Variable* var = nextVariable();
+        if (var == nullptr) break;
+        if (!var->assigned) batch.push_back(var);
+      }
+    }
+    if (sidBatchFixing) {
+      if (fixBatch(batch))
+        fixedVariables = assignFraction;
+      else
+        totalBatchFallbacks++;
+    }
+
+    // -------------------------------------------------------------------------
+    // Failed literal probing: both values of every candidate of the batch are
+    // tried with UP, and undone, before any candidate is fixed. When only one
+    // value fails, the other one is implied by the assignment so far and is
+    // fixed now (or the candidate is left for the next step with
+    // sidProbeSkip if its preferred value failed)
+    // -------------------------------------------------------------------------
+    if (sidProbing && fixedVariables < assignFraction) {
+      vector<Variable*> probed;
+      for (Variable* var : batch) {
+        if (var->assigned) continue;
+        evaluateVar(var);
+        bool newValue = var->Hp > var->Hm ? false : true;
+        bool preferred = probe(var, newValue);
+        bool other = probe(var, !newValue);
+        if (preferred && other) {
+          probed.push_back(var);
+          continue;
+        }
+
+        if (preferred || other) {
+          totalFailedLiterals++;
+          if (sidProbeSkip && !preferred) continue;
+          if (decideVariable(var, preferred ? newValue : !newValue)) {
+            fixedVariables++;
+            continue;
+          }
+        }
+
+        // The assignment of the previous steps (and the implied values) is
+        // already a contradiction
+        if (totalRetries >= sidMaxRetries) return CONTRADICTION;
+        totalRetries++;
+        rollBackStep();
+        break;
+      }
+      batch = probed;
+    }
+
+    while (!rolledBack && fixedVariables < assignFraction) {
+      Variable* var =
+          batchNext < batch.size() ? batch[batchNext++] : nextVariable();
+      if (var == nullptr) break;
+
       // Variables in the list can be already assigned due to UP being executed
       // in previous iterations
-      if (unassignedVariables[i]->assigned) {
-        auxAssign++;  // Don't count this variable as a new assignation
-        continue;
-      }
+      if (var->assigned) continue;  // Don't count this variable
 
       // Found the new value and assign the variable
       // The assignation method cleans the graph and execute UP if one of
       // the cleaned clause become unitary
-      Variable* var = unassignedVariables[i];
 
       // Recalculate biases for same reason, previous assignations clean the
       // graph and change relations
       evaluateVar(var);
       bool newValue = var->Hp > var->Hm ? false : true;
 
-      if (!assignVariable(var, newValue)) {
+      if (!decideVariable(var, newValue)) {
         // Error found when assigning variable
-        return CONTRADICTION;
+        if (totalRetries >= sidMaxRetries) return CONTRADICTION;
+        totalRetries++;
+
+        // The value leads to a contradiction given the previous assignments,
+        // so the variable can only take the other one
+        revertStep(trail.size() - 1);
+        trail.pop_back();
+        if (!decideVariable(var, !newValue)) {
+          rollBackStep();
+          break;
+        }
+      }
+      fixedVariables++;
+    }
+    if (rolledBack) continue;
+    progress.retryBatch = 0;
+
+    // Unfixed variables fixed again by this step
+    if (sidBacktracking) {
+      for (size_t step = stepStart; step < trail.size(); step++) {
+        for (Variable* var : trail[step].variables) {
+          signed char& unfixed = unfixedValue[var->id - 1];
+          if (unfixed >= 0 && unfixed != var->value) totalRefixedOpposite++;
+          unfixed = -1;
+        }
       }
     }
 
@@ -141,24 +414,31 @@ AlgorithmResult Solver::SID(FactorGraph* graph, double fraction) {
 }
 
 AlgorithmResult Solver::surveyPropagation() {
+  if (spSchedule == COMMUNITY_SCHEDULE) return communitySurveyPropagation();
+
   // Calculate subproducts of all variables
   computeSubProducts();
+  fusedBiasesReady = false;
+  if (spEarlyFixing) polarizedSweeps.assign(fg->variables.size(), 0);
+  double maxConvergeDiff = 1.0;
   for (int i = 0; i < spMaxIt; i++) {
+    if (cancelled()) return CANCELLED;
+    if (timedOut()) return TIMEOUT;
     totalSPIterations++;
     // cout << "." << flush;
     // Randomize clause iteration
     vector<Clause*> enabledClauses = fg->GetEnabledClauses();
     shuffle(enabledClauses.begin(), enabledClauses.end(), randomGenerator);
 
-    // Calculate surveys
-    double maxConvergeDiff = 0.0;
-    for (Clause* clause : enabledClauses) {
-      double maxConvDiffInClause = updateSurveys(clause);
+    // Bet on this sweep being the last one (and compute the biases in it)
+    // if the previous one almost converged or the surveys come from the
+    // previous decimation step. Early fixing needs the biases of every sweep
+    bool lastSweep = i == 0 ? spWarmStart
+                            : maxConvergeDiff <= spFuseFactor * spEpsilon;
 
-      // Save max convergence diff
-      if (maxConvDiffInClause > maxConvergeDiff)
-        maxConvergeDiff = maxConvDiffInClause;
-    }
+    // Calculate surveys
+    maxConvergeDiff = sweepClauses(
+        enabledClauses, spEarlyFixing || (spFuseBiases && lastSweep));
 
     // Check if converged
     if (maxConvergeDiff <= spEpsilon) {
@@ -178,189 +458,784 @@ AlgorithmResult Solver::surveyPropagation() {
       // If not triavial return and continue algorith
       return CONVERGE;
     }
+
+    // Fix the variables that stay polarised and continue on the reduced graph
+    if (spEarlyFixing && !earlyFixVariables()) return CONTRADICTION;
   }
   // cout << ":-(" << endl;
   // Max itertions reach without convergence
   return UNCONVERGE;
 }
 
-void Solver::computeSubProducts() {
-  for (Variable* var : fg->variables) {
-    if (!var->assigned) {
-      var->p = 1.0;
-      var->m = 1.0;
-      var->pzero = 0;
-      var->mzero = 0;
-
-      // For each edge connecting the variable to a clause
-      for (Edge* edge : var->allNeighbourEdges) {
-        if (edge->enabled) {
-          // If edge is negative update positive subproduct of variable
-          if (!edge->type) {
-            // If edge survey != 1
-            if (1.0 - edge->survey > ZERO_EPSILON) {
-              var->p *= 1.0 - edge->survey;
-            }
-            // If edge survey == 1
-            else
-              var->pzero++;
-          }
-          // If edge is positive, update negative subproduct of variable
-          else {
-            // If edge survey != 1
-            if (1.0 - edge->survey > ZERO_EPSILON) {
-              var->m *= 1.0 - edge->survey;
+AlgorithmResult Solver::communitySurveyPropagation() {
+  // Calculate subproducts of all variables
+  computeSubProducts();
+  fusedBiasesReady = false;
+
+  // -------------------------------------------------------------------------
+  // Split the enabled clauses into the ones inside a community and the
+  // boundary ones (with variables of more than one community)
+  // -------------------------------------------------------------------------
+  int totalCommunities = 0;
+  for (int community : communities)
+    totalCommunities = max(totalCommunities, community + 1);
+
+  vector<vector<Clause*>> internalClauses(totalCommunities);
+  vector<Clause*> boundaryClauses;
+  for (Clause* clause : fg->GetEnabledClauses()) {
+    int community = -1;
+    for (Edge* edge : clause->allNeighbourEdges) {
+      if (!edge->enabled) continue;
+      int edgeCommunity = communities[edge->variable->id - 1];
+      if (community == -1)
+        community = edgeCommunity;
+      else if (community != edgeCommunity)
+        community = -2;
+    }
+
+    if (community >= 0)
+      internalClauses[community].push_back(clause);
+    else
+      boundaryClauses.push_back(clause);
+  }
+
+  vector<unsigned long> communitySeeds(totalCommunities);
+  vector<double> firstSweepDiff(totalCommunities);
+  vector<int> localSweeps(totalCommunities);
+  for (int i = 0; i < spMaxIt; i++) {
+    if (cancelled()) return CANCELLED;
+    if (timedOut()) return TIMEOUT;
+    totalSPIterations++;
+
+    // Random streams of the communities are drawn in order from the main
+    // generator, so the result does not depend on which thread runs them
+    for (unsigned long& seed : communitySeeds) seed = randomGenerator();
+
+    // -----------------------------------------------------------------------
+    // Local phase: communities share no variables through their internal
+    // clauses, so they can be iterated at the same time. The outcome of each
+    // one does not depend on the thread, so tasks are grabbed dynamically
+    // -----------------------------------------------------------------------
+    getPool()->Run(
+        totalCommunities,
+        [&](int c, unsigned) {
+          mt19937 communityGenerator(communitySeeds[c]);
+          vector<Clause*>& clauses = internalClauses[c];
+          firstSweepDiff[c] = 0.0;
+          localSweeps[c] = 0;
+
+          for (int local = 0; local < spLocalMaxIt; local++) {
+            localSweeps[c]++;
+            shuffle(clauses.begin(), clauses.end(), communityGenerator);
+
+            double maxConvergeDiff = 0.0;
+            for (Clause* clause : clauses) {
+              double maxConvDiffInClause = updateClause(clause);
+              if (maxConvDiffInClause > maxConvergeDiff)
+                maxConvergeDiff = maxConvDiffInClause;
             }
-            // If edge survey == 1
-            else
-              var->mzero++;
+
+            if (local == 0) firstSweepDiff[c] = maxConvergeDiff;
+            if (maxConvergeDiff <= spEpsilon) break;
           }
-        }
-      }
+        },
+        false);
+    for (int sweeps : localSweeps) totalSPLocalSweeps += sweeps;
+
+    // ------------------------------------------------------
+    // Boundary phase: exchange surveys between communities
+    // ------------------------------------------------------
+    shuffle(boundaryClauses.begin(), boundaryClauses.end(), randomGenerator);
+    double maxConvergeDiff = sweepClauses(boundaryClauses);
+
+    // Converged if a whole sweep (first local one plus boundary) is stable
+    for (double diff : firstSweepDiff) {
+      if (diff > maxConvergeDiff) maxConvergeDiff = diff;
     }
+    if (maxConvergeDiff <= spEpsilon) return CONVERGE;
   }
+
+  // Max itertions reach without convergence
+  return UNCONVERGE;
 }
 
-double Solver::updateSurveys(Clause* clause) {
-  double maxConvDiffInClause = 0.0;
-  int zeros = 0;
-  double allSubSurveys = 1.0;
-  vector<double> subSurveys;
+double Solver::sweepClauses(const vector<Clause*>& order, bool withBiases) {
+  ThreadPool* threads = getPool();
+  double maxConvergeDiff = 0.0;
+
+  // ---------------------------------------------------------------------------
+  // Fused sweep: the bias of a variable is final once its last clause in the
+  // sweep is updated, so it is evaluated right there while it is in cache.
+  // The max biases are added in fixed point, which is exact and therefore
+  // independent of the order and the number of threads
+  // ---------------------------------------------------------------------------
+  atomic<long long> fusedSum(0);
+  atomic<bool> fusedNaN(false);
+  if (withBiases) {
+    varLastClause.assign(fg->variables.size(), -1);
+    for (size_t c = 0; c < order.size(); c++) {
+      for (Edge* edge : order[c]->allNeighbourEdges) {
+        if (edge->enabled) varLastClause[edge->variable->id - 1] = c;
+      }
+    }
+  }
+
+  auto update = [&](int c, long long& biasSum) {
+    double maxConvDiffInClause = updateClause(order[c]);
+    if (!withBiases) return maxConvDiffInClause;
 
-  // ==================================================================
-  // Calculate subProducts of all literals and keep track of wich are 0
-  // ==================================================================
-  for (Edge* edge : clause->allNeighbourEdges) {
-    if (edge->enabled && !edge->variable->assigned) {
+    for (Edge* edge : order[c]->allNeighbourEdges) {
       Variable* var = edge->variable;
-      double m, p, wn, wt;
-
-      // If edge is negative:
-      if (!edge->type) {
-        m = var->mzero ? 0 : var->m;
-        if (var->pzero == 0)
-          p = var->p / (1.0 - edge->survey);
-        else if (var->pzero == 1 && (1.0 - edge->survey) < ZERO_EPSILON)
-          p = var->p;
-        else
-          p = 0.0;
+      if (!edge->enabled || varLastClause[var->id - 1] != c) continue;
 
-        wn = p * (1.0 - m);
-        wt = m;
+      evaluateVar(var);
+      double bias = engine == BP_ENGINE ? var->evalValue
+                                        : (var->Hp > var->Hm ? var->Hp : var->Hm);
+      if (std::isnan(bias))
+        fusedNaN = true;
+      else
+        biasSum += llround(bias * FIXED_POINT_ONE);
+    }
+    return maxConvDiffInClause;
+  };
+
+  // Sequential sweep in the given order
+  if (threads->size() == 1) {
+    long long biasSum = 0;
+    for (size_t c = 0; c < order.size(); c++) {
+      double maxConvDiffInClause = update(c, biasSum);
+
+      // Save max convergence diff
+      if (maxConvDiffInClause > maxConvergeDiff)
+        maxConvergeDiff = maxConvDiffInClause;
+    }
+    fusedSum = biasSum;
+  }
+
+  // ---------------------------------------------------------------------------
+  // Parallel sweep. Clauses only interact through the subproducts of the
+  // variables they share, so each clause is placed in the wave after the last
+  // wave that touched any of its variables. Clauses in the same wave are
+  // independent and every variable still sees its clauses in the given order,
+  // which makes the result identical to the sequential sweep.
+  // ---------------------------------------------------------------------------
+  else {
+    varWave.assign(fg->variables.size(), 0);
+    vector<int> clauseWave(order.size());
+    int totalWaves = 0;
+    for (size_t c = 0; c < order.size(); c++) {
+      int wave = 0;
+      for (Edge* edge : order[c]->allNeighbourEdges) {
+        if (edge->enabled && varWave[edge->variable->id - 1] > wave)
+          wave = varWave[edge->variable->id - 1];
       }
-      // If edge is positive
-      else {
-        p = var->pzero ? 0 : var->p;
-        if (var->mzero == 0)
-          m = var->m / (1.0 - edge->survey);
-        else if (var->mzero == 1 && (1.0 - edge->survey) < ZERO_EPSILON)
-          m = var->m;
-        else
-          m = 0.0;
+      for (Edge* edge : order[c]->allNeighbourEdges) {
+        if (edge->enabled) varWave[edge->variable->id - 1] = wave + 1;
+      }
+      clauseWave[c] = wave;
+      if (wave + 1 > totalWaves) totalWaves = wave + 1;
+    }
+
+    // Counting sort of the clauses by wave, keeping the order inside each wave
+    waveStart.assign(totalWaves + 1, 0);
+    for (int wave : clauseWave) waveStart[wave + 1]++;
+    for (int w = 0; w < totalWaves; w++) waveStart[w + 1] += waveStart[w];
+    waveClauses.resize(order.size());
+    vector<int> fill(waveStart.begin(), waveStart.end() - 1);
+    for (size_t c = 0; c < order.size(); c++)
+      waveClauses[fill[clauseWave[c]]++] = c;
+
+    // Max is exact, so the partial maxima can be combined in any order
+    vector<double> taskMax;
+    for (int w = 0; w < totalWaves; w++) {
+      int begin = waveStart[w];
+      int size = waveStart[w + 1] - begin;
+      int tasks = (size + parallelGrain - 1) / parallelGrain;
+      taskMax.assign(tasks, 0.0);
+
+      threads->Run(
+          tasks,
+          [&](int t, unsigned) {
+            long long biasSum = 0;
+            int end = min(begin + (t + 1) * parallelGrain, begin + size);
+            for (int c = begin + t * parallelGrain; c < end; c++) {
+              double maxConvDiffInClause = update(waveClauses[c], biasSum);
+              if (maxConvDiffInClause > taskMax[t])
+                taskMax[t] = maxConvDiffInClause;
+            }
+            fusedSum += biasSum;
+          },
+          deterministic);
 
-        wn = m * (1 - p);
-        wt = p;
+      for (double diff : taskMax) {
+        if (diff > maxConvergeDiff) maxConvergeDiff = diff;
       }
+    }
+  }
 
-      // Calculate subSurvey
-      double subSurvey = wn / (wn + wt);
-      subSurveys.push_back(subSurvey);
-
-      // If subsurvey is 0 keep track but don't multiply
-      if (subSurvey < ZERO_EPSILON) {
-        zeros++;
-        if (zeros == 2) break;
-      } else
-        allSubSurveys *= subSurvey;
-    }
-  }
-
-  // =========================================================
-  // Calculate the survey for each edge with the previous data
-  // =========================================================
-  int i = 0;
-  for (Edge* edge : clause->allNeighbourEdges) {
-    if (edge->enabled && !edge->variable->assigned) {
-      // ---------------------------------------------
-      // Calculate new survey from sub survey products
-      // ---------------------------------------------
-      double newSurvey;
-      // If there where no subSurveys == 0, proceed normaly
-      if (!zeros) newSurvey = allSubSurveys / subSurveys[i];
-      // If this subsurvey is the only one that is 0
-      // consider the new survey as the total subSurveys
-      else if (zeros == 1 && subSurveys[i] < ZERO_EPSILON)
-        newSurvey = allSubSurveys;
-      // If there where more that one subSurveys == 0, the new survey is 0
-      else
-        newSurvey = 0.0;
+  // A sweep without biases leaves the ones of an earlier sweep stale
+  fusedBiasesReady = withBiases && !fusedNaN;
+  if (withBiases) fusedSumMaxBias = (double)fusedSum / FIXED_POINT_ONE;
 
-      // ----------------------------------------------------
-      // Update the variable subproducts with new survey info
-      // ----------------------------------------------------
-      Variable* var = edge->variable;
-      // If edge is negative update positive subproduct
-      if (!edge->type) {
-        // If previous survey != 1 (with an epsilon margin)
-        if (1.0 - edge->survey > ZERO_EPSILON) {
-          // If new survey != 1, update the sub product with the difference
-          if (1.0 - newSurvey > ZERO_EPSILON)
-            var->p *= ((1.0 - newSurvey) / (1.0 - edge->survey));
-          // If new survey == 1, update the subproduct by remove the old survey
-          // and keep track of the new survey == 1 (pzero++)
-          else {
-            var->p /= (1.0 - edge->survey);
-            var->pzero++;
-          }
-        }
-        // If previous survey == 1
-        else {
-          // If new survey == 1, don't do anything (both surveys are the same)
-          // If new survey != 1, update subproduct
-          if (1.0 - newSurvey > ZERO_EPSILON) {
-            var->p *= (1.0 - newSurvey);
-            var->pzero--;
-          }
+  return maxConvergeDiff;
+}
+
+bool Solver::earlyFixVariables() {
+  // The biases were computed in the last sweep. The count of a variable is
+  // positive while it leans to true and negative while it leans to false
+  bool fixed = false;
+  for (Variable* var : fg->variables) {
+    int& sweeps = polarizedSweeps[var->id - 1];
+    if (var->assigned || !(var->evalValue >= spEarlyFixBias)) {
+      sweeps = 0;
+      continue;
+    }
+
+    bool value = var->Hp > var->Hm ? false : true;
+    if (value)
+      sweeps = sweeps > 0 ? sweeps + 1 : 1;
+    else
+      sweeps = sweeps < 0 ? sweeps - 1 : -1;
+    if (abs(sweeps) < spEarlyFixSweeps) continue;
+
+    // A contradiction uses a retry as in a decimation step: the variable takes
+    // the other value, and if that fails too SID undoes the step
+    if (!decideVariable(var, value)) {
+      if (!recordTrail || totalRetries >= sidMaxRetries) return false;
+      totalRetries++;
+      revertStep(trail.size() - 1);
+      trail.pop_back();
+      if (!decideVariable(var, !value)) return false;
+    }
+    totalEarlyFixed++;
+    fixed = true;
+  }
+
+  // The disabled edges must leave the subproducts of their variables
+  if (fixed) computeSubProducts();
+  return true;
+}
+
+void Solver::computeSubProducts() {
+  const vector<Variable*>& vars = fg->variables;
+  int tasks = (vars.size() + parallelGrain - 1) / parallelGrain;
+
+  getPool()->Run(
+      tasks,
+      [&](int t, unsigned) {
+        size_t end = min((size_t)(t + 1) * parallelGrain, vars.size());
+        for (size_t v = (size_t)t * parallelGrain; v < end; v++) {
+          Variable* var = vars[v];
+          if (var->assigned) continue;
+          double p = var->p, m = var->m;
+          int pzero = var->pzero, mzero = var->mzero;
+          kernels->computeSubProducts(var);
+
+          if (sidIncrementalBiases &&
+              (var->p != p || var->m != m || var->pzero != pzero ||
+               var->mzero != mzero))
+            markBiasDirty(var);
+
+          // Variables without surveys (or with all of them 0) may not be
+          // updated by a fused sweep, so their bias is evaluated here
+          if (var->p == 1.0 && var->m == 1.0 && !var->pzero && !var->mzero)
+            evaluateVar(var);
         }
+      },
+      deterministic);
+}
+
+bool Solver::decideVariable(Variable* var, bool value) {
+  if (!recordTrail) return assignVariable(var, value);
+
+  // The decision and its unit propagation are one step of the trail
+  currentStep = trail.size();
+  trail.emplace_back();
+  decisionStep[var->id - 1] = currentStep;
+  bool result = assignVariable(var, value);
+  currentStep = -1;
+  return result;
+}
+
+bool Solver::probe(Variable* var, bool value) {
+  bool result = decideVariable(var, value);
+  revertStep(trail.size() - 1);
+  trail.pop_back();
+  return result;
+}
+
+void Solver::revertStep(int step) {
+  for (Variable* var : trail[step].variables) {
+    decisionStep[var->id - 1] = -1;
+    if (sidIncrementalBiases) markBiasDirty(var);
+  }
+  trail[step].Revert();
+}
+
+void Solver::restartFromConverged(size_t firstStep) {
+  // Fresh stream for every restart, independent of the main generator
+  seed_seq restartSeed{initialSeed, (unsigned long)totalRestarts};
+  mt19937 restartGenerator(restartSeed);
+
+  // Without a converged state every survey is reinitialised
+  if (convergedSurveys.empty()) {
+    for (Edge* edge : fg->edges) edge->survey = randomReal01UD(restartGenerator);
+    return;
+  }
+
+  // Undo the steps fixed after the last converged SP
+  vector<Variable*> undone;
+  for (size_t step = trail.size(); step-- > firstStep;) {
+    undone.insert(undone.end(), trail[step].variables.begin(),
+                  trail[step].variables.end());
+    revertStep(step);
+  }
+  trail.resize(firstStep);
+
+  // Surveys of that state, except the clauses around the undone variables
+  for (size_t e = 0; e < fg->edges.size(); e++)
+    fg->edges[e]->survey = convergedSurveys[e];
+  for (Variable* var : undone) {
+    for (Edge* edge : var->allNeighbourEdges) {
+      for (Edge* other : edge->clause->allNeighbourEdges)
+        other->survey = randomReal01UD(restartGenerator);
+    }
+  }
+}
+
+AlgorithmResult Solver::ResumeSID(FactorGraph* graph, double fraction,
+                                  const string& path) {
+  resumePath = path;
+  return SID(graph, fraction);
+}
+
+// -----------------------------------------------------------------------------
+// Checkpoints
+//
+// Binary file: header (magic, sizes of the graph), counters, progress of the
+// schedule, then the state of every variable, clause and edge in graph order,
+// the trail, the last converged surveys and the random generator
+// -----------------------------------------------------------------------------
+namespace {
+
+const char CHECKPOINT_MAGIC[8] = {'S', 'I', 'D', 'C', 'K', 'P', 'T', '7'};
+
+template <typename T>
+void writeValue(ostream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(istream& in, T& value) {
+  return (bool)in.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+bool Solver::writeCheckpoint(const SIDProgress& progress) {
+  // Written aside and renamed, so a crash never leaves a partial checkpoint
+  string tmpPath = sidCheckpointPath + ".tmp";
+  ofstream out(tmpPath, ios::binary | ios::trunc);
+  if (!out.is_open()) return false;
+
+  out.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+  writeValue<uint32_t>(out, fg->variables.size());
+  writeValue<uint32_t>(out, fg->clauses.size());
+  writeValue<uint32_t>(out, fg->edges.size());
+
+  writeValue<int32_t>(out, totalSPIterations);
+  writeValue<int32_t>(out, totalSPLocalSweeps);
+  writeValue<int32_t>(out, totalSIDIterations);
+  writeValue<int32_t>(out, totalEarlyFixed);
+  writeValue<int32_t>(out, totalUnfixed);
+  writeValue<int32_t>(out, totalRetries);
+  writeValue<int32_t>(out, totalRestarts);
+  writeValue<int32_t>(out, totalFailedLiterals);
+  writeValue<int32_t>(out, totalBatchFallbacks);
+  writeValue<int32_t>(out, totalResidualSwitches);
+  writeValue<int32_t>(out, totalRefixedOpposite);
+  writeValue<int64_t>(out, totalConflicts);
+
+  writeValue<double>(out, progress.batchScale);
+  writeValue<int32_t>(out, progress.retryBatch);
+  writeValue<uint64_t>(out, progress.lastStepStart);
+  writeValue<int32_t>(out, progress.lastBatch);
+  writeValue<int32_t>(out, progress.failedResidual);
+  writeValue<int32_t>(out, progress.densityResidual);
+  writeValue<int32_t>(out, progress.unfixedLast);
+
+  for (Variable* var : fg->variables) {
+    writeValue<uint8_t>(out, var->assigned | var->value << 1 |
+                                 (unfixedValue[var->id - 1] + 1) << 2);
+    writeValue<int32_t>(out, decisionStep[var->id - 1]);
+  }
+  for (Clause* clause : fg->clauses) {
+    writeValue<uint8_t>(out, clause->enabled);
+    writeValue<int32_t>(out, clause->trueLiterals);
+  }
+  for (Edge* edge : fg->edges) {
+    writeValue<uint8_t>(out, edge->enabled);
+    writeValue<double>(out, edge->survey);
+  }
+
+  writeValue<uint32_t>(out, trail.size());
+  for (AssignmentStep& step : trail) {
+    writeValue<uint32_t>(out, step.variables.size());
+    for (Variable* var : step.variables) writeValue<uint32_t>(out, var->id);
+  }
+
+  writeValue<uint32_t>(out, convergedSurveys.size());
+  for (double survey : convergedSurveys) writeValue<double>(out, survey);
+
+  ostringstream generator;
+  generator << randomGenerator;
+  string generatorState = generator.str();
+  writeValue<uint32_t>(out, generatorState.size());
+  out.write(generatorState.data(), generatorState.size());
+
+  out.close();
+  if (!out) return false;
+  return rename(tmpPath.c_str(), sidCheckpointPath.c_str()) == 0;
+}
+
+bool Solver::readCheckpoint(const string& path, SIDProgress& progress) {
+  ifstream in(path, ios::binary);
+  if (!in.is_open()) return false;
+
+  char magic[sizeof(CHECKPOINT_MAGIC)];
+  uint32_t variables, clauses, edges;
+  if (!in.read(magic, sizeof(magic)) ||
+      !equal(magic, magic + sizeof(magic), CHECKPOINT_MAGIC) ||
+      !readValue(in, variables) || !readValue(in, clauses) ||
+      !readValue(in, edges) || variables != fg->variables.size() ||
+      clauses != fg->clauses.size() || edges != fg->edges.size())
+    return false;
+
+  int32_t counters[11];
+  int64_t conflicts;
+  for (int32_t& counter : counters) {
+    if (!readValue(in, counter)) return false;
+  }
+  if (!readValue(in, conflicts)) return false;
+  totalSPIterations = counters[0];
+  totalSPLocalSweeps = counters[1];
+  totalSIDIterations = counters[2];
+  totalEarlyFixed = counters[3];
+  totalUnfixed = counters[4];
+  totalRetries = counters[5];
+  totalRestarts = counters[6];
+  totalFailedLiterals = counters[7];
+  totalBatchFallbacks = counters[8];
+  totalResidualSwitches = counters[9];
+  totalRefixedOpposite = counters[10];
+  totalConflicts = conflicts;
+
+  int32_t retryBatch, lastBatch, failedResidual, densityResidual, unfixedLast;
+  uint64_t lastStepStart;
+  if (!readValue(in, progress.batchScale) || !readValue(in, retryBatch) ||
+      !readValue(in, lastStepStart) || !readValue(in, lastBatch) ||
+      !readValue(in, failedResidual) || !readValue(in, densityResidual) ||
+      !readValue(in, unfixedLast))
+    return false;
+  progress.retryBatch = retryBatch;
+  progress.lastStepStart = lastStepStart;
+  progress.lastBatch = lastBatch;
+  progress.failedResidual = failedResidual;
+  progress.densityResidual = densityResidual;
+  progress.unfixedLast = unfixedLast;
+
+  for (Variable* var : fg->variables) {
+    uint8_t state;
+    int32_t step;
+    if (!readValue(in, state) || !readValue(in, step)) return false;
+    var->assigned = state & 1;
+    var->value = state >> 1 & 1;
+    unfixedValue[var->id - 1] = (state >> 2) - 1;
+    decisionStep[var->id - 1] = step;
+  }
+  for (Clause* clause : fg->clauses) {
+    uint8_t enabled;
+    int32_t trueLiterals;
+    if (!readValue(in, enabled) || !readValue(in, trueLiterals)) return false;
+    clause->enabled = enabled;
+    clause->trueLiterals = trueLiterals;
+  }
+  for (Edge* edge : fg->edges) {
+    uint8_t enabled;
+    if (!readValue(in, enabled) || !readValue(in, edge->survey)) return false;
+    edge->enabled = enabled;
+  }
+
+  uint32_t steps;
+  if (!readValue(in, steps)) return false;
+  trail.assign(steps, AssignmentStep());
+  for (AssignmentStep& step : trail) {
+    uint32_t size, id;
+    if (!readValue(in, size)) return false;
+    for (uint32_t i = 0; i < size; i++) {
+      if (!readValue(in, id) || id < 1 || id > variables) return false;
+      step.variables.push_back(fg->variables[id - 1]);
+    }
+  }
+
+  uint32_t surveys;
+  if (!readValue(in, surveys)) return false;
+  convergedSurveys.resize(surveys);
+  for (double& survey : convergedSurveys) {
+    if (!readValue(in, survey)) return false;
+  }
+
+  uint32_t generatorSize;
+  if (!readValue(in, generatorSize)) return false;
+  string generatorState(generatorSize, '\0');
+  if (!in.read(&generatorState[0], generatorSize)) return false;
+  istringstream generator(generatorState);
+  generator >> randomGenerator;
+  return !generator.fail();
+}
+
+bool Solver::residualIsCheap(SIDProgress& progress) {
+  if (sidResidualVariables <= 0 && sidResidualDensity <= 0.0) return false;
+
+  // Only the assigned flags, the features read every edge and clause
+  int unassigned = 0;
+  for (Variable* var : fg->variables) {
+    if (!var->assigned) unassigned++;
+  }
+  if (progress.failedResidual > 0 && unassigned > progress.failedResidual / 2)
+    return false;
+  if (unassigned <= sidResidualVariables) return true;
+
+  // The density is checked again when an eighth of the variables of the last
+  // check has been assigned
+  if (sidResidualDensity <= 0.0 ||
+      (progress.densityResidual > 0 &&
+       unassigned > progress.densityResidual - progress.densityResidual / 8))
+    return false;
+  progress.densityResidual = unassigned;
+  return ExtractFeatures(fg, false).relativeDensity < sidResidualDensity;
+}
+
+void Solver::branchDecimation(int batch) {
+  // The batch and the candidates after it, in decimation order (the biases of
+  // every unassigned variable are up to date)
+  vector<Variable*> candidates = fg->GetUnassignedVariables();
+  size_t window = SelectVariables(candidates, 0, batch + sidBranchWidth - 1);
+  if (window <= (size_t)batch) return;
+
+  Variable* last = candidates[batch - 1];
+  vector<pair<unsigned, bool>> decisions;
+  for (int i = 0; i < batch - 1; i++) {
+    Variable* var = candidates[i];
+    decisions.push_back({var->id, var->Hp > var->Hm ? false : true});
+  }
+
+  for (size_t i = batch; i < window; i++) {
+    Variable* candidate = candidates[i];
+    if (std::abs(last->evalValue) - std::abs(candidate->evalValue) >
+        sidBranchGap)
+      break;
+
+    decisions.push_back(
+        {candidate->id, candidate->Hp > candidate->Hm ? false : true});
+    onBranch(fg, decisions);
+    decisions.pop_back();
+  }
+}
+
+// Support of a fixed variable for its value: the bias it would have without
+// the assignment (the clauses it satisfies are recomputed locally from the
+// current surveys). Negative if SP now prefers the opposite value
+double Solver::fixedSupport(Variable* var) {
+  double p = 1.0, m = 1.0;
+
+  for (Edge* edge : var->allNeighbourEdges) {
+    Clause* clause = edge->clause;
+
+    // Warning of the clause to the variable (product of the sub surveys of the
+    // other unassigned variables). Clauses satisfied by other assignments do
+    // not send warnings
+    double warning = 1.0;
+    bool satisfied = false;
+    for (Edge* other : clause->allNeighbourEdges) {
+      Variable* neighbour = other->variable;
+      if (neighbour == var) continue;
+      if (neighbour->assigned) {
+        if (neighbour->value == other->type) satisfied = true;
+        continue;
       }
-      // If edge is positive, update negative subproduct
-      else {
-        // If previous survey != 1 (with an epsilon margin)
-        if (1.0 - edge->survey > ZERO_EPSILON) {
-          // If new survey != 1, update the sub product with the difference
-          if (1.0 - newSurvey > ZERO_EPSILON)
-            var->m *= ((1.0 - newSurvey) / (1.0 - edge->survey));
-          // If new survey == 1, update the subproduct by remove the old survey
-          // and keep track of the new survey == 1 (pzero++)
-          else {
-            var->m /= (1.0 - edge->survey);
-            var->mzero++;
-          }
-        }
-        // If previous survey == 1
-        else {
-          // If new survey == 1, don't do anything (both surveys are the same)
-          // If new survey != 1, update subproduct
-          if (1.0 - newSurvey > ZERO_EPSILON) {
-            var->m *= (1.0 - newSurvey);
-            var->mzero--;
-          }
-        }
+
+      // Cavity products of the neighbour without this clause
+      const double sameProduct = other->type ? neighbour->m : neighbour->p;
+      int sameZeros = other->type ? neighbour->mzero : neighbour->pzero;
+      double same = sameProduct;
+      if (other->enabled) {
+        if (1.0 - other->survey > ZERO_EPSILON)
+          same = sameProduct / (1.0 - other->survey);
+        else
+          sameZeros--;
       }
+      if (sameZeros > 0) same = 0.0;
+      const int oppositeZeros = other->type ? neighbour->pzero : neighbour->mzero;
+      const double opposite =
+          oppositeZeros ? 0.0 : (other->type ? neighbour->p : neighbour->m);
+
+      const double wn = engine == BP_ENGINE ? same : same * (1.0 - opposite);
+      warning *= wn / (wn + opposite);
+    }
+    if (satisfied) continue;
+
+    // Same subproducts as the kernels (p over negative edges)
+    (edge->type ? m : p) *= 1.0 - warning;
+  }
+
+  // Same normalization as the variable kernels
+  double hz = engine == BP_ENGINE ? 0.0 : p * m;
+  double hp = m - hz;
+  double hm = p - hz;
+  double sum = hm + hz + hp;
+  return (var->value ? hm - hp : hp - hm) / sum;
+}
+
+int Solver::unfixVariables(int maxUnfix) {
+  if (maxUnfix < 1) return 0;
+
+  // Decisions whose support dropped below the threshold, weakest first
+  vector<pair<double, Variable*>> candidates;
+  for (Variable* var : fg->variables) {
+    if (!var->assigned || decisionStep[var->id - 1] < 0) continue;
+    double support = fixedSupport(var);
+    if (support < bspUnfixBias) candidates.push_back({support, var});
+  }
+
+  int total = min(maxUnfix, (int)candidates.size());
+  partial_sort(candidates.begin(), candidates.begin() + total, candidates.end(),
+               [](const pair<double, Variable*>& l,
+                  const pair<double, Variable*>& r) {
+                 if (l.first != r.first) return l.first < r.first;
+                 return l.second->id < r.second->id;
+               });
+
+  // Each decision is unfixed with the variables its unit propagation assigned
+  int unfixed = 0;
+  for (int i = 0; i < total; i++) {
+    int step = decisionStep[candidates[i].second->id - 1];
+    if (step < 0) continue;
+    unfixed += trail[step].variables.size();
+    for (Variable* var : trail[step].variables)
+      unfixedValue[var->id - 1] = var->value;
+    revertStep(step);
+  }
+  totalUnfixed += unfixed;
+  return unfixed;
+}
+
+bool Solver::fixBatch(const vector<Variable*>& batch) {
+  // Every claimed variable, in the order it was claimed by each round. The
+  // biases of the batch were evaluated at the start of the step
+  vector<Variable*> claimed;
+  for (Variable* var : batch) {
+    claims[var->id - 1] = var->Hp > var->Hm ? 1 : 2;
+    claimed.push_back(var);
+  }
+
+  // -------------------------------------------------------------------------
+  // Unit propagation in rounds. The graph is only read: a clause is
+  // satisfied, unit or empty depending on the claims of its enabled
+  // literals. Every variable claimed in a round is propagated in the next
+  // one, when the claims of the round before are visible to every thread
+  // -------------------------------------------------------------------------
+  atomic<bool> conflict(false);
+  int grain = max(1, parallelGrain / 16);  // A variable visits all its clauses
+  size_t roundStart = 0;
+  while (roundStart < claimed.size() && !conflict) {
+    size_t roundSize = claimed.size() - roundStart;
+    int tasks = (roundSize + grain - 1) / grain;
+    vector<vector<Variable*>> implied(tasks);
+
+    getPool()->Run(
+        tasks,
+        [&](int t, unsigned) {
+          size_t end = min(roundStart + (size_t)(t + 1) * grain,
+                           claimed.size());
+          for (size_t i = roundStart + (size_t)t * grain; i < end; i++) {
+            Variable* var = claimed[i];
+            bool value = claims[var->id - 1] == 2;
+
+            for (Edge* edge : var->allNeighbourEdges) {
+              if (conflict) return;
+              if (!edge->enabled || edge->type == value) continue;
+
+              // The literal is false: look for a true or free one
+              Edge* free = nullptr;
+              int freeLiterals = 0;
+              bool satisfied = false;
+              for (Edge* e : edge->clause->allNeighbourEdges) {
+                if (!e->enabled) continue;
+                unsigned char claim = claims[e->variable->id - 1];
+                if (claim == 0) {
+                  free = e;
+                  freeLiterals++;
+                } else if ((claim == 2) == e->type) {
+                  satisfied = true;
+                  break;
+                }
+              }
+              if (satisfied || freeLiterals > 1) continue;
+              if (freeLiterals == 0) {
+                conflict = true;
+                return;
+              }
+
+              // Unit clause: the free variable is claimed by one thread
+              unsigned char expected = 0;
+              unsigned char claim = free->type ? 2 : 1;
+              if (claims[free->variable->id - 1].compare_exchange_strong(
+                      expected, claim))
+                implied[t].push_back(free->variable);
+              else if (expected != claim)
+                conflict = true;
+            }
+          }
+        },
+        true);
+
+    roundStart = claimed.size();
+    for (vector<Variable*>& vars : implied)
+      claimed.insert(claimed.end(), vars.begin(), vars.end());
+  }
 
-      // ----------------------------------------------------
-      // Store new survey and update max clause converge diff
-      // ----------------------------------------------------
-      double edgeConvDiff = std::abs(edge->survey - newSurvey);
-      if (maxConvDiffInClause < edgeConvDiff)
-        maxConvDiffInClause = std::abs(edgeConvDiff);
+  if (conflict) {
+    for (Variable* var : claimed) claims[var->id - 1] = 0;
+    return false;
+  }
 
-      edge->survey = newSurvey;
-      i++;
+  // -------------------------------------------------------------------------
+  // Apply the claims: the same graph updates as assignVariable, without UP
+  // (the claims are already closed under it). The batch is one trail step
+  // -------------------------------------------------------------------------
+  if (recordTrail) {
+    currentStep = trail.size();
+    trail.emplace_back();
+    for (Variable* var : batch) decisionStep[var->id - 1] = currentStep;
+  }
+  for (Variable* var : claimed) {
+    var->AssignValue(claims[var->id - 1] == 2);
+    claims[var->id - 1] = 0;
+    if (currentStep >= 0) trail[currentStep].variables.push_back(var);
+    if (sidIncrementalBiases) forgetBias(var);
+
+    for (Edge* edge : var->allNeighbourEdges) {
+      if (!edge->enabled) continue;
+      if (edge->type == var->value)
+        edge->clause->Dissable();
+      else
+        edge->Dissable();
     }
   }
+  currentStep = -1;
 
-  return maxConvDiffInClause;
+  return true;
 }
 
 bool Solver::assignVariable(Variable* var, bool value) {
@@ -371,6 +1246,8 @@ bool Solver::assignVariable(Variable* var, bool value) {
   }
 
   var->AssignValue(value);
+  if (currentStep >= 0) trail[currentStep].variables.push_back(var);
+  if (sidIncrementalBiases) forgetBias(var);
   return cleanGraph(var);
 }
 
@@ -412,22 +1289,251 @@ bool Solver::unitPropagation(Clause* clause) {
   return true;
 }
 
-void Solver::evaluateVar(Variable* var) {
-  double p = var->pzero ? 0 : var->p;
-  double m = var->mzero ? 0 : var->m;
+bool DecimationOrder(const Variable* lvar, const Variable* rvar) {
+  double lbias = std::abs(lvar->evalValue);
+  double rbias = std::abs(rvar->evalValue);
+  if (std::isnan(lbias)) lbias = -1.0;
+  if (std::isnan(rbias)) rbias = -1.0;
+  if (lbias != rbias) return lbias > rbias;
+  return lvar->id < rvar->id;
+}
+
+size_t Solver::SelectVariables(vector<Variable*>& vars, size_t first,
+                               size_t count) {
+  if (first >= vars.size() || count == 0) return 0;
+  count = min(count, vars.size() - first);
+  auto begin = vars.begin() + first;
+  auto end = vars.end();
+  auto selectedEnd = begin + count;
+  size_t size = end - begin;
+
+  if (numThreads > 1 && size > 2 * (size_t)parallelGrain) {
+    // -------------------------------------------------------------------------
+    // Every block keeps its own best count variables, the last selected one is
+    // the count-th best of the candidates. The order is total, so it is the
+    // same variable for any number of threads
+    // -------------------------------------------------------------------------
+    int tasks = (size + parallelGrain - 1) / parallelGrain;
+    vector<vector<Variable*>> candidates(tasks);
+    getPool()->Run(
+        tasks,
+        [&](int t, unsigned) {
+          auto blockBegin = begin + (size_t)t * parallelGrain;
+          auto blockEnd = blockBegin + min(size - (size_t)t * parallelGrain,
+                                           (size_t)parallelGrain);
+          size_t keep = min(count, (size_t)(blockEnd - blockBegin));
+          nth_element(blockBegin, blockBegin + keep - 1, blockEnd,
+                      DecimationOrder);
+          candidates[t].assign(blockBegin, blockBegin + keep);
+        },
+        deterministic);
+
+    vector<Variable*> merged;
+    for (vector<Variable*>& block : candidates)
+      merged.insert(merged.end(), block.begin(), block.end());
+    nth_element(merged.begin(), merged.begin() + count - 1, merged.end(),
+                DecimationOrder);
+    const Variable* last = merged[count - 1];
+
+    partition(begin, end, [last](const Variable* var) {
+      return !DecimationOrder(last, var);
+    });
+  } else {
+    nth_element(begin, selectedEnd - 1, end, DecimationOrder);
+  }
+
+  sort(begin, selectedEnd, DecimationOrder);
+  return count;
+}
+
+void Solver::resetBiasQueue() {
+  biasQueue.Reset(fg->variables);
+  biasDirty.assign(fg->variables.size(), 1);
+  biasDirtyList = fg->variables;
+  biasDirtyCount = fg->variables.size();
+  biasFixed.assign(fg->variables.size(), 0);
+  biasFixedSum = 0;
+  biasNaNs = 0;
+}
+
+double Solver::updateBiasQueue() {
+  // Biases of the variables whose subproducts changed since they were queued.
+  // The rest keep exactly the bias they have in the queue
+  vector<Variable*> changed;
+  for (size_t d = 0; d < biasDirtyCount; d++) {
+    Variable* var = biasDirtyList[d];
+    biasDirty[var->id - 1] = 0;
+    if (!var->assigned) changed.push_back(var);
+  }
+  biasDirtyCount = 0;
+
+  // Already evaluated if the biases were fused with the last SP sweep
+  if (!fusedBiasesReady) evaluateVars(changed);
+
+  // The fixed point sum is exact, so updating it gives the same value as
+  // adding all the biases again
+  for (Variable* var : changed) {
+    forgetBias(var);
+    double bias = engine == BP_ENGINE ? var->evalValue
+                                      : (var->Hp > var->Hm ? var->Hp : var->Hm);
+    long long& fixed = biasFixed[var->id - 1];
+    if (std::isnan(bias)) {
+      fixed = LLONG_MIN;
+      biasNaNs++;
+    } else {
+      fixed = llround(bias * FIXED_POINT_ONE);
+      biasFixedSum += fixed;
+    }
+    biasQueue.Update(var);
+  }
+
+  return biasNaNs ? NAN : (double)biasFixedSum / FIXED_POINT_ONE;
+}
+
+void Solver::forgetBias(Variable* var) {
+  if (!biasQueue.Contains(var)) return;
+
+  long long fixed = biasFixed[var->id - 1];
+  if (fixed == LLONG_MIN)
+    biasNaNs--;
+  else
+    biasFixedSum -= fixed;
+  biasQueue.Remove(var);
+}
+
+double Solver::evaluateVars(const vector<Variable*>& vars) {
+  // Each task sums the max bias of a fixed block of variables. The blocks do
+  // not depend on the number of threads, so adding them with a fixed tree
+  // gives the same sum for any numThreads
+  int tasks = (vars.size() + parallelGrain - 1) / parallelGrain;
+  vector<double> partials(tasks, 0.0);
+  double sumMaxBias = 0.0;
+  mutex sumMutex;
+
+  getPool()->Run(
+      tasks,
+      [&](int t, unsigned) {
+        size_t first = (size_t)t * parallelGrain;
+        int count = min(vars.size() - first, (size_t)parallelGrain);
+        double blockSum = kernels->evaluateVars(vars.data() + first, count,
+                                                engine == BP_ENGINE);
+
+        if (deterministic) {
+          partials[t] = blockSum;
+        } else {
+          lock_guard<mutex> lock(sumMutex);
+          sumMaxBias += blockSum;
+        }
+      },
+      deterministic);
+
+  return deterministic ? TreeSum(partials) : sumMaxBias;
+}
+
+AlgorithmResult Solver::SurveyPropagation(FactorGraph* graph,
+                                          double& sumMaxBias) {
+  fg = graph;
+  startBudget();
+  totalSPIterations = 0;
+  totalSPLocalSweeps = 0;
+  totalEarlyFixed = 0;
+  if (spSchedule == COMMUNITY_SCHEDULE) communities = DetectCommunities(fg);
+
+  // Same state as at the start of SID (early fixing decides variables)
+  recordTrail = false;
+  decisionStep.assign(fg->variables.size(), -1);
+  if (sidIncrementalBiases) resetBiasQueue();
+
+  spWarmStart = true;
+  AlgorithmResult result = surveyPropagation();
+  if (result != CONVERGE) return result;
+
+  // The same sum SID would decimate with
+  if (sidIncrementalBiases)
+    sumMaxBias = updateBiasQueue();
+  else
+    sumMaxBias = fusedBiasesReady ? fusedSumMaxBias
+                                  : evaluateVars(fg->GetUnassignedVariables());
+  return result;
+}
 
-  var->Hz = p * m;
-  var->Hp = m - var->Hz;
-  var->Hm = p - var->Hz;
+AlgorithmResult Solver::LocalSearch(FactorGraph* graph) {
+  fg = graph;
+  startBudget();
+  totalSPIterations = 0;
+  totalSIDIterations = 0;
+  totalConflicts = 0;
 
-  // Normalize
-  double sum = var->Hm + var->Hz + var->Hp;
-  var->Hz /= sum;
-  var->Hp /= sum;
-  var->Hm /= sum;
+  vector<Variable*> variables = fg->GetUnassignedVariables();
+  AlgorithmResult result = solveResidual();
+  if (result != SAT && result != TIMEOUT) {
+    for (Variable* var : variables) var->UnassignValue();
+  }
+  return result;
+}
 
-  // Store eval value
-  var->evalValue = std::abs(var->Hp - var->Hm);
+AlgorithmResult Solver::timeout() {
+  bestSatisfiedClauses = 0;
+  for (Clause* clause : fg->clauses) bestSatisfiedClauses += clause->IsSAT();
+  return TIMEOUT;
+}
+
+AlgorithmResult Solver::solveResidual() {
+  if (residualSolver == CDCL_RESIDUAL)
+    return cdcl(fg->GetUnassignedVariables(), fg->GetEnabledClauses());
+
+  // Walksat assigns the residual variables, so the subformula is taken before
+  vector<Variable*> variables;
+  vector<Clause*> clauses;
+  if (residualSolver == WALKSAT_CDCL_RESIDUAL) {
+    variables = fg->GetUnassignedVariables();
+    clauses = fg->GetEnabledClauses();
+  }
+
+  AlgorithmResult result = walksat();
+  if (result != INDETERMINATE || residualSolver != WALKSAT_CDCL_RESIDUAL)
+    return result;
+
+  return cdcl(variables, clauses);
+}
+
+AlgorithmResult Solver::cdcl(const vector<Variable*>& variables,
+                             const vector<Clause*>& clauses) {
+  // Residual variables are numbered from 1 in the order of the graph
+  vector<int> residualId(fg->variables.size(), 0);
+  for (size_t i = 0; i < variables.size(); i++) {
+    residualId[variables[i]->id - 1] = i + 1;
+  }
+
+  CDCL solver(variables.size());
+  solver.maxConflicts = cdclMaxConflicts;
+  solver.cancel = cancel;
+  if (timeBudget > 0.0) solver.deadline = deadline;
+
+  // The enabled edges of an enabled clause are its unassigned literals
+  vector<int> literals;
+  for (Clause* clause : clauses) {
+    literals.clear();
+    for (Edge* edge : clause->allNeighbourEdges) {
+      if (!edge->enabled) continue;
+      int id = residualId[edge->variable->id - 1];
+      literals.push_back(edge->type ? id : -id);
+    }
+    if (!solver.AddClause(literals)) return CONTRADICTION;
+  }
+
+  AlgorithmResult result = solver.Solve();
+  totalConflicts += solver.totalConflicts;
+  if (result == TIMEOUT) return timeout();
+  cout << "CDCL: " << solver.totalConflicts << " conflicts, "
+       << solver.totalDecisions << " decisions" << endl;
+
+  if (result == SAT) {
+    for (size_t i = 0; i < variables.size(); i++) {
+      variables[i]->AssignValue(solver.Value(i + 1));
+    }
+  }
+  return result;
 }
 
 AlgorithmResult Solver::walksat() {
@@ -438,6 +1544,17 @@ AlgorithmResult Solver::walksat() {
   cout << "Subformula has " << clauses.size() << " clauses and "
        << variables.size() << " variables" << endl;
 
+  // With a time budget, the assignment with fewest unsat clauses is kept and
+  // left in the graph if no solution is found
+  bool keepBest = timeBudget > 0.0;
+  size_t bestUnsat = clauses.size() + 1;
+  vector<char> bestValues;
+  auto restoreBest = [&]() {
+    if (bestValues.empty()) return;
+    for (size_t i = 0; i < variables.size(); i++)
+      variables[i]->AssignValue(bestValues[i]);
+  };
+
   vector<Clause*> unsatClauses;
   for (int t = 0; t < wsMaxTries; t++) {
     // Assign all Varibles with random values
@@ -452,9 +1569,21 @@ AlgorithmResult Solver::walksat() {
     }
 
     for (int f = 0; f < wsMaxFlips; f++) {
+      if (cancelled()) return CANCELLED;
       // If there are no unsat clauses, subgraph is solved and it's SAT
       if (unsatClauses.size() == 0) return SAT;
 
+      if (keepBest && unsatClauses.size() < bestUnsat) {
+        bestUnsat = unsatClauses.size();
+        bestValues.resize(variables.size());
+        for (size_t i = 0; i < variables.size(); i++)
+          bestValues[i] = variables[i]->value;
+      }
+      if (f % 1024 == 0 && timedOut()) {
+        restoreBest();
+        return timeout();
+      }
+
       // Select random unsat clause
       std::uniform_int_distribution<> randomInt(0, unsatClauses.size() - 1);
       int randIndex = randomInt(randomGenerator);
@@ -545,6 +1674,7 @@ AlgorithmResult Solver::walksat() {
   }
 
   // 2. If a sat assignment was not found, return false.
+  restoreBest();
   return INDETERMINATE;
 }
 
@@ -0,0 +1,92 @@
+// Project headers
+#include <ThreadPool.hpp>
+
+namespace sat {
+
+// =============================================================================
+// ThreadPool class
+// =============================================================================
+ThreadPool::ThreadPool(unsigned size) : nextTask(0) {
+  for (unsigned i = 1; i < size; i++) {
+    workers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::Run(int numTasks, const Task& task, bool staticSchedule) {
+  if (numTasks <= 0) return;
+
+  // Nothing to share, avoid the synchronization cost
+  if (workers.empty() || numTasks == 1) {
+    for (int t = 0; t < numTasks; t++) task(t, 0);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    job = &task;
+    jobTasks = numTasks;
+    jobStatic = staticSchedule;
+    nextTask = 0;
+    pendingWorkers = workers.size();
+    generation++;
+  }
+  wakeUp.notify_all();
+
+  runTasks(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  allDone.wait(lock, [this] { return pendingWorkers == 0; });
+  job = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned threadIndex) {
+  unsigned long seenGeneration = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wakeUp.wait(lock, [&] { return stopping || generation != seenGeneration; });
+      if (stopping) return;
+      seenGeneration = generation;
+    }
+
+    runTasks(threadIndex);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pendingWorkers == 0) allDone.notify_one();
+  }
+}
+
+void ThreadPool::runTasks(unsigned threadIndex) {
+  if (jobStatic) {
+    for (int t = threadIndex; t < jobTasks; t += size()) (*job)(t, threadIndex);
+  } else {
+    for (int t = nextTask++; t < jobTasks; t = nextTask++)
+      (*job)(t, threadIndex);
+  }
+}
+
+// =============================================================================
+// Reductions
+// =============================================================================
+double TreeSum(std::vector<double>& partials) {
+  if (partials.empty()) return 0.0;
+
+  for (size_t width = 1; width < partials.size(); width *= 2) {
+    for (size_t i = 0; i + width < partials.size(); i += 2 * width) {
+      partials[i] += partials[i + width];
+    }
+  }
+
+  return partials[0];
+}
+
+}  // namespace sat
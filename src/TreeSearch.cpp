@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+
+// Project headers
+#include <ThreadPool.hpp>
+#include <TreeSearch.hpp>
+
+namespace sat {
+
+namespace {
+
+// A pending branch: the graph before its step and the decisions of its batch
+struct Branch {
+  size_t residual;
+  int index;
+  FactorGraph* graph;
+  std::vector<std::pair<unsigned, bool>> decisions;
+};
+
+// Smallest residual first, then the oldest branch
+struct WorseBranch {
+  bool operator()(const Branch& a, const Branch& b) const {
+    if (a.residual != b.residual) return a.residual > b.residual;
+    return a.index > b.index;
+  }
+};
+
+}  // namespace
+
+// =============================================================================
+// TreeSearch
+// =============================================================================
+TreeSearch::TreeSearch(int seed, double fraction)
+    : seed(seed), fraction(fraction) {}
+
+TreeSearchResult TreeSearch::Run(FactorGraph* graph) {
+  TreeSearchResult search;
+  AlgorithmResult rootResult = INDETERMINATE;
+
+  std::priority_queue<Branch, std::vector<Branch>, WorseBranch> pending;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::atomic<bool> solved(false);
+  int active = 0;
+
+  pending.push({graph->GetEnabledClauses().size(), search.branches++,
+                new FactorGraph(*graph), {}});
+
+  int workers = std::max(1, numThreads);
+  ThreadPool pool(workers);
+  pool.Run(
+      workers,
+      [&](int, unsigned) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+          // Wait for a branch, unless nobody can create one anymore
+          changed.wait(lock, [&] {
+            return solved || !pending.empty() || active == 0;
+          });
+          if (solved || pending.empty()) break;
+
+          Branch branch = pending.top();
+          pending.pop();
+          active++;
+          lock.unlock();
+
+          FactorGraph* fg = branch.graph;
+          int N = fg->variables.size();
+          Solver solver(N, (double)fg->clauses.size() / N, seed + branch.index);
+          if (setup) setup(solver);
+          solver.cancel = &solved;
+          solver.sidBranchGap = branchGap;
+          solver.sidBranchWidth = branchWidth;
+          solver.sidKeepSurveys = branch.index > 0;
+          solver.sidInitialDecisions = branch.decisions;
+          solver.onBranch =
+              [&](const FactorGraph* state,
+                  const std::vector<std::pair<unsigned, bool>>& decisions) {
+                std::lock_guard<std::mutex> guard(mutex);
+                if (solved || search.branches >= maxBranches) return;
+                FactorGraph* fork = new FactorGraph(*state);
+                pending.push({fork->GetEnabledClauses().size(),
+                              search.branches++, fork, decisions});
+                changed.notify_one();
+              };
+
+          AlgorithmResult result = solver.SID(fg, fraction);
+
+          lock.lock();
+          active--;
+          search.explored++;
+          if (branch.index == 0) rootResult = result;
+          if (result == SAT) {
+            // The first SAT branch wins and stops the rest
+            if (!solved) {
+              graph->CopyState(fg);
+              solved = true;
+            }
+          } else if (result != CANCELLED) {
+            search.pruned++;
+          }
+          delete fg;
+          changed.notify_all();
+        }
+      },
+      false);
+
+  while (!pending.empty()) {
+    delete pending.top().graph;
+    pending.pop();
+  }
+
+  search.result = solved ? SAT : rootResult;
+  return search;
+}
+
+}  // namespace sat
@@ -0,0 +1,63 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <BatchSurveyPropagation.hpp>
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+TEST_CASE("Algorithm - Batch Survey Propagation (converge)", "[integration]") {
+  // More instances than lanes and of different sizes: the second group is
+  // padded and the lanes converge after different sweeps
+  const char* files[] = {
+      "./test/cnf/1.cnf",  "./test/cnf/2.cnf",  "./test/cnf/3.cnf",
+      "./test/cnf/11.cnf", "./test/cnf/4.cnf",  "./test/cnf/6.cnf",
+      "./test/cnf/8.cnf",  "./test/cnf/10.cnf", "./test/cnf/12.cnf",
+      "./test/cnf/13.cnf", "./test/cnf/14.cnf"};
+
+  std::vector<sat::FactorGraph*> graphs;
+  for (const char* path : files) {
+    std::ifstream file(path);
+    if (!file.is_open()) FAIL("ERROR: Can't open file " << path);
+    graphs.push_back(new sat::FactorGraph(file));
+    file.close();
+  }
+  REQUIRE(graphs.size() > SP_BATCH_LANES);
+
+  std::vector<sat::FactorGraph*> copies;
+  for (sat::FactorGraph* graph : graphs)
+    copies.push_back(new sat::FactorGraph(*graph));
+
+  sat::BatchSurveyPropagation batch(7357);
+  batch.numThreads = 2;
+  std::vector<sat::SPBatchResult> results = batch.Run(graphs);
+
+  // Each instance has its own stream, so one thread gives the same surveys
+  sat::BatchSurveyPropagation single(7357);
+  std::vector<sat::SPBatchResult> singleResults = single.Run(copies);
+
+  REQUIRE(results.size() == graphs.size());
+  for (size_t i = 0; i < results.size(); i++) {
+    INFO("cnf: " << files[i]);
+    CHECK(results[i].result == sat::CONVERGE);
+    CHECK(results[i].iterations > 0);
+    CHECK(results[i].iterations == singleResults[i].iterations);
+    for (size_t e = 0; e < graphs[i]->edges.size(); e++) {
+      sat::Edge* edge = graphs[i]->edges[e];
+      // Up to rounding
+      CHECK(edge->survey >= -1.0e-12);
+      CHECK(edge->survey <= 1.0 + 1.0e-12);
+      CHECK(edge->survey == copies[i]->edges[e]->survey);
+    }
+
+    // The surveys are a fixed point of the scalar SP
+    int N = graphs[i]->variables.size();
+    sat::Solver solver(N, (double)graphs[i]->clauses.size() / N, 7357);
+    double sumMaxBias;
+    CHECK(solver.SurveyPropagation(graphs[i], sumMaxBias) == sat::CONVERGE);
+    CHECK(solver.totalSPIterations == 1);
+  }
+
+  for (sat::FactorGraph* graph : copies) delete graph;
+  for (sat::FactorGraph* graph : graphs) delete graph;
+};
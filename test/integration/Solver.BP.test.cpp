@@ -0,0 +1,38 @@
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+#include <Validator.hpp>
+
+// BP is only meant for densities below the clustering (13.cnf has 3.5
+// clauses per variable); on 11.cnf (4.0) it does not converge
+TEST_CASE("Solver - SID guided by BP", "[integration]") {
+  const char* files[] = {"./test/cnf/1.cnf", "./test/cnf/6.cnf",
+                         "./test/cnf/10.cnf", "./test/cnf/13.cnf"};
+
+  for (const char* path : files) {
+    std::ifstream file(path);
+    if (!file.is_open()) FAIL("ERROR: Can't open file " << path);
+    sat::FactorGraph* graph = new sat::FactorGraph(file);
+    file.close();
+
+    int N = graph->variables.size();
+    sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+    solver.engine = sat::BP_ENGINE;
+
+    INFO("cnf: " << path);
+    REQUIRE(solver.SID(graph, 0.04) == sat::SAT);
+    CHECK(graph->IsSAT());
+
+    // Checked again against the cnf file
+    graph->storeVariableValues("./bp.sol");
+    Validator validator;
+    CHECK(validator.validateResult(path, "./bp.sol"));
+    std::remove("./bp.sol");
+
+    delete graph;
+  }
+};
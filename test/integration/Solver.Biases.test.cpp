@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Kernels.hpp>
+#include <Solver.hpp>
+
+// Biases of the graph evaluated again from its surveys, and their sum
+static double freshBiases(sat::FactorGraph* graph, std::vector<double>& Hp,
+                          std::vector<double>& Hm) {
+  const sat::Kernels* kernels = sat::SelectKernels();
+  sat::FactorGraph* copy = new sat::FactorGraph(*graph);
+  double sumMaxBias = 0.0;
+  Hp.clear();
+  Hm.clear();
+  for (sat::Variable* var : copy->variables) {
+    kernels->computeSubProducts(var);
+    kernels->evaluateVar(var);
+    Hp.push_back(var->Hp);
+    Hm.push_back(var->Hm);
+    if (!var->assigned) sumMaxBias += std::max(var->Hp, var->Hm);
+  }
+  delete copy;
+  return sumMaxBias;
+}
+
+TEST_CASE("Solver - Biases of a warm started SP (same as evaluating again)",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  // Only the first sweep computes the biases, and it does not converge from
+  // random surveys
+  solver.spFuseBiases = true;
+  solver.spFuseFactor = 0.0;
+  solver.spEpsilon = 1.0e-7;
+
+  std::mt19937 generator(7357);
+  std::uniform_real_distribution<> random01;
+
+  for (bool incremental : {true, false}) {
+    for (sat::SPSchedule schedule :
+         {sat::RANDOM_SCHEDULE, sat::COMMUNITY_SCHEDULE}) {
+      INFO("incremental: " << incremental << ", schedule: " << schedule);
+      for (sat::Edge* edge : graph->edges) edge->survey = random01(generator);
+      solver.sidIncrementalBiases = incremental;
+      solver.spSchedule = schedule;
+
+      double sumMaxBias;
+      REQUIRE(solver.SurveyPropagation(graph, sumMaxBias) == sat::CONVERGE);
+      REQUIRE(solver.totalSPIterations > 1);
+
+      // The fixed point sum of the queue rounds every bias to 2^-40
+      std::vector<double> Hp, Hm;
+      CHECK(sumMaxBias == Approx(freshBiases(graph, Hp, Hm)).epsilon(1.0e-9));
+      for (int v = 0; v < N; v++) {
+        if (graph->variables[v]->assigned) continue;
+        CHECK(graph->variables[v]->Hp == Approx(Hp[v]).margin(1.0e-12));
+        CHECK(graph->variables[v]->Hm == Approx(Hm[v]).margin(1.0e-12));
+      }
+    }
+  }
+
+  delete graph;
+};
+
+// Variables of the cnf with biases from a converged SP, with a few NaN and
+// repeated biases so the order of the ties matters
+static sat::FactorGraph* graphWithBiases(const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) FAIL("ERROR: Can't open file " + path);
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  double sumMaxBias;
+  REQUIRE(solver.SurveyPropagation(graph, sumMaxBias) == sat::CONVERGE);
+
+  for (int v = 0; v < N; v += 13) graph->variables[v]->evalValue = NAN;
+  for (int v = 5; v < N; v += 17) graph->variables[v]->evalValue = 0.5;
+  return graph;
+}
+
+TEST_CASE("Solver - Top k selection (same as a full sort)", "[integration]") {
+  sat::FactorGraph* graph = graphWithBiases("./test/cnf/11.cnf");
+  std::vector<sat::Variable*> sorted = graph->variables;
+  std::sort(sorted.begin(), sorted.end(), sat::DecimationOrder);
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.parallelGrain = 16;
+
+  for (int threads : {1, 4}) {
+    solver.numThreads = threads;
+    for (size_t count : {1, 7, 30, 150, 299, 300, 400}) {
+      INFO("threads: " << threads << ", count: " << count);
+      std::vector<sat::Variable*> vars = graph->variables;
+      size_t selected = solver.SelectVariables(vars, 0, count);
+      REQUIRE(selected == std::min(count, sorted.size()));
+      CHECK(std::equal(vars.begin(), vars.begin() + selected, sorted.begin()));
+
+      // The next ones, from where the last selection ended
+      size_t next = solver.SelectVariables(vars, selected, count);
+      CHECK(next == std::min(count, sorted.size() - selected));
+      CHECK(std::equal(vars.begin(), vars.begin() + selected + next,
+                       sorted.begin()));
+    }
+  }
+
+  delete graph;
+};
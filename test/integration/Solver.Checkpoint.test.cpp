@@ -0,0 +1,50 @@
+#include <catch2/catch.hpp>
+#include <cstdio>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+// Run SID (or resume it from a checkpoint) and return the result followed by
+// the value of every variable (-1 if not assigned) and the SP iterations
+std::vector<int> solveWithCheckpoint(int checkpointSteps,
+                                     const std::string& resumePath) {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.sidCheckpointPath = "./sid.checkpoint";
+  solver.sidCheckpointSteps = checkpointSteps;
+
+  std::vector<int> assignment;
+  assignment.push_back(resumePath.empty()
+                           ? solver.SID(graph, 0.01)
+                           : solver.ResumeSID(graph, 0.01, resumePath));
+  for (sat::Variable* var : graph->variables) {
+    assignment.push_back(var->assigned ? var->value : -1);
+  }
+  assignment.push_back(solver.totalSPIterations);
+
+  delete graph;
+  return assignment;
+}
+
+TEST_CASE("Solver - Checkpoint (resume gives the same run)", "[integration]") {
+  std::remove("./sid.checkpoint");
+  std::vector<int> full = solveWithCheckpoint(2, "");
+  REQUIRE(full[0] == sat::SAT);
+
+  std::vector<int> resumed = solveWithCheckpoint(0, "./sid.checkpoint");
+  CHECK(resumed == full);
+
+  std::remove("./sid.checkpoint");
+};
+
+TEST_CASE("Solver - Checkpoint (missing file)", "[integration]") {
+  std::vector<int> resumed = solveWithCheckpoint(0, "./missing.checkpoint");
+  CHECK(resumed[0] == sat::INDETERMINATE);
+};
@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+#include <random>
+
+// Project headders
+#include <Communities.hpp>
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+TEST_CASE("Communities - Partition of two known communities",
+          "[integration]") {
+  std::ifstream file("./test/cnf/12.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/12.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  std::vector<int> communities = sat::DetectCommunities(graph);
+  REQUIRE(communities.size() == 12);
+  for (int v = 1; v < 6; v++) CHECK(communities[v] == communities[0]);
+  for (int v = 7; v < 12; v++) CHECK(communities[v] == communities[6]);
+  CHECK(communities[0] != communities[6]);
+
+  delete graph;
+};
+
+// Surveys of SP with the given schedule, from the same initial surveys, and
+// the global and local sweeps it took
+std::vector<double> fixedPoint(const std::string& path,
+                               sat::SPSchedule schedule, int& sweeps,
+                               int& localSweeps) {
+  std::ifstream file(path);
+  if (!file.is_open()) FAIL("ERROR: Can't open file " + path);
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  std::mt19937 generator(7357);
+  std::uniform_real_distribution<> random01;
+  for (sat::Edge* edge : graph->edges) edge->survey = random01(generator);
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.spSchedule = schedule;
+  solver.spEpsilon = 1.0e-7;
+
+  double sumMaxBias;
+  REQUIRE(solver.SurveyPropagation(graph, sumMaxBias) == sat::CONVERGE);
+  sweeps = solver.totalSPIterations;
+  localSweeps = solver.totalSPLocalSweeps;
+
+  std::vector<double> surveys;
+  for (sat::Edge* edge : graph->edges) surveys.push_back(edge->survey);
+  delete graph;
+  return surveys;
+}
+
+TEST_CASE("Communities - Same SP fixed point as the random schedule",
+          "[integration]") {
+  const char* files[] = {"./test/cnf/12.cnf", "./test/cnf/11.cnf"};
+
+  for (const char* path : files) {
+    INFO("cnf: " << path);
+    int randomSweeps, randomLocal, communitySweeps, communityLocal;
+    std::vector<double> random =
+        fixedPoint(path, sat::RANDOM_SCHEDULE, randomSweeps, randomLocal);
+    std::vector<double> community = fixedPoint(
+        path, sat::COMMUNITY_SCHEDULE, communitySweeps, communityLocal);
+
+    CHECK(randomLocal == 0);
+    CHECK(communityLocal > 0);
+    REQUIRE(random.size() == community.size());
+    for (size_t e = 0; e < random.size(); e++) {
+      CHECK(community[e] == Approx(random[e]).margin(1.0e-4));
+    }
+  }
+};
+
+TEST_CASE("Communities - Fewer global sweeps than the random schedule",
+          "[integration]") {
+  // Cold start on two communities joined by one clause: each one converges
+  // with local sweeps, and the global sweeps only settle the joining clause
+  int randomSweeps, randomLocal, communitySweeps, communityLocal;
+  fixedPoint("./test/cnf/12.cnf", sat::RANDOM_SCHEDULE, randomSweeps,
+             randomLocal);
+  fixedPoint("./test/cnf/12.cnf", sat::COMMUNITY_SCHEDULE, communitySweeps,
+             communityLocal);
+
+  CHECK(communitySweeps < randomSweeps);
+};
@@ -0,0 +1,204 @@
+#include <catch2/catch.hpp>
+#include <functional>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+// Result of a SID run, the value of every variable (-1 if not assigned) and
+// the solver counters
+struct DecimationRun {
+  sat::AlgorithmResult result;
+  std::vector<int> values;
+  bool sat;  // The assignment satisfies the formula
+  int sidIterations;
+  int earlyFixed;
+  int unfixed;
+  int refixedOpposite;
+  int retries;
+  int restarts;
+};
+
+// SID on the cnf with the options set by configure
+DecimationRun decimate(const std::string& path, double fraction,
+                       std::function<void(sat::Solver&)> configure,
+                       int seed = 7357) {
+  std::ifstream file(path);
+  if (!file.is_open()) FAIL("ERROR: Can't open file " + path);
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, seed);
+  configure(solver);
+
+  DecimationRun run;
+  run.result = solver.SID(graph, fraction);
+  for (sat::Variable* var : graph->variables)
+    run.values.push_back(var->assigned ? var->value : -1);
+  run.sat = graph->IsSAT();
+  run.sidIterations = solver.totalSIDIterations;
+  run.earlyFixed = solver.totalEarlyFixed;
+  run.unfixed = solver.totalUnfixed;
+  run.refixedOpposite = solver.totalRefixedOpposite;
+  run.retries = solver.totalRetries;
+  run.restarts = solver.totalRestarts;
+
+  delete graph;
+  return run;
+}
+
+TEST_CASE("Decimation - Adaptive fraction (constant without room to grow)",
+          "[integration]") {
+  const char* path = "./test/cnf/11.cnf";
+  DecimationRun constant = decimate(path, 0.005, [](sat::Solver&) {});
+  REQUIRE(constant.result == sat::SAT);
+
+  // Without room to grow it is the constant schedule
+  DecimationRun fixed = decimate(path, 0.005, [](sat::Solver& solver) {
+    solver.sidAdaptiveFraction = true;
+    solver.sidMaxFraction = 0.005;
+  });
+  CHECK(fixed.result == constant.result);
+  CHECK(fixed.values == constant.values);
+  CHECK(fixed.sidIterations == constant.sidIterations);
+
+  // Every step counts as fast and polarised, so the batch grows to 8 times
+  DecimationRun adaptive = decimate(path, 0.005, [](sat::Solver& solver) {
+    solver.sidAdaptiveFraction = true;
+    solver.sidMaxFraction = 0.04;
+    solver.sidFastSweeps = solver.spMaxIt;
+    solver.sidPolarizedBias = 0.0;
+  });
+  CHECK(adaptive.result == sat::SAT);
+  CHECK(adaptive.sat);
+  CHECK(adaptive.sidIterations < constant.sidIterations);
+};
+
+TEST_CASE("Decimation - Early fixing (same as SP without it if none fixed)",
+          "[integration]") {
+  const char* paths[] = {"./test/cnf/11.cnf", "./test/cnf/13.cnf"};
+
+  for (const char* path : paths) {
+    INFO("cnf: " << path);
+    DecimationRun plain = decimate(path, 0.04, [](sat::Solver&) {});
+
+    // No bias reaches the threshold: only the biases of every sweep change
+    DecimationRun never = decimate(path, 0.04, [](sat::Solver& solver) {
+      solver.spEarlyFixing = true;
+      solver.spEarlyFixBias = 1.5;
+    });
+    CHECK(never.result == plain.result);
+    CHECK(never.values == plain.values);
+    CHECK(never.earlyFixed == 0);
+  }
+
+  // The biases of 13.cnf (ratio 3.5) are too weak to fix any early
+  DecimationRun early =
+      decimate("./test/cnf/11.cnf", 0.04, [](sat::Solver& solver) {
+        solver.spEarlyFixing = true;
+      });
+  CHECK(early.result == sat::SAT);
+  CHECK(early.sat);
+  CHECK(early.earlyFixed > 0);
+};
+
+TEST_CASE("Decimation - Backtracking fixes decisions the other way",
+          "[integration]") {
+  // Near the threshold some decisions lose the support of SP, and with the
+  // surveys SP finds without them a few are fixed with the other value
+  auto backtracking = [](bool incremental) {
+    return [incremental](sat::Solver& solver) {
+      solver.sidIncrementalBiases = incremental;
+      solver.sidBacktracking = true;
+    };
+  };
+  DecimationRun incremental =
+      decimate("./test/cnf/15.cnf", 0.01, backtracking(true));
+  CHECK(incremental.unfixed > 0);
+  CHECK(incremental.refixedOpposite > 0);
+
+  // Some surveys become NaN, the queue must see those changes too
+  DecimationRun full = decimate("./test/cnf/15.cnf", 0.01, backtracking(false));
+  CHECK(full.result == incremental.result);
+  CHECK(full.values == incremental.values);
+  CHECK(full.unfixed == incremental.unfixed);
+  CHECK(full.refixedOpposite == incremental.refixedOpposite);
+};
+
+TEST_CASE("Decimation - Retries after contradictions", "[integration]") {
+  // Large steps: a decision of the first ones fails
+  auto retries = [](int maxRetries) {
+    return [maxRetries](sat::Solver& solver) {
+      solver.sidMaxRetries = maxRetries;
+    };
+  };
+  DecimationRun none = decimate("./test/cnf/11.cnf", 0.5, retries(0), 1);
+  CHECK(none.result == sat::CONTRADICTION);
+  CHECK(none.retries == 0);
+
+  DecimationRun retried = decimate("./test/cnf/11.cnf", 0.5, retries(3), 1);
+  CHECK(retried.result == sat::SAT);
+  CHECK(retried.sat);
+  CHECK(retried.retries > 0);
+
+  // Early fixing with a low threshold: a variable fixed inside SP fails
+  auto earlyRetries = [](int maxRetries) {
+    return [maxRetries](sat::Solver& solver) {
+      solver.sidMaxRetries = maxRetries;
+      solver.spEarlyFixing = true;
+      solver.spEarlyFixBias = 0.8;
+      solver.spEarlyFixSweeps = 2;
+    };
+  };
+  none = decimate("./test/cnf/11.cnf", 0.04, earlyRetries(0), 1);
+  CHECK(none.result == sat::CONTRADICTION);
+  CHECK(none.earlyFixed > 0);
+
+  retried = decimate("./test/cnf/11.cnf", 0.04, earlyRetries(5), 1);
+  CHECK(retried.result == sat::SAT);
+  CHECK(retried.sat);
+  CHECK(retried.retries > 0);
+};
+
+TEST_CASE("Decimation - Restarts after SP does not converge",
+          "[integration]") {
+  // Few sweeps: the first SP converges and the one after the first step
+  // does not
+  auto restarts = [](int maxRestarts) {
+    return [maxRestarts](sat::Solver& solver) {
+      solver.sidMaxRestarts = maxRestarts;
+      solver.spMaxIt = 40;
+    };
+  };
+  DecimationRun none = decimate("./test/cnf/11.cnf", 0.04, restarts(0), 5);
+  CHECK(none.result == sat::UNCONVERGE);
+  CHECK(none.sidIterations == 2);
+  CHECK(none.restarts == 0);
+
+  DecimationRun restarted =
+      decimate("./test/cnf/11.cnf", 0.04, restarts(5), 5);
+  CHECK(restarted.result == sat::SAT);
+  CHECK(restarted.sat);
+  CHECK(restarted.restarts > 0);
+};
+
+TEST_CASE("Decimation - Batch fixing on graphs of different sizes",
+          "[integration]") {
+  // The same solver (with the parameters of the larger one) on a small graph
+  // and then on a larger one
+  sat::Solver solver(300, 4.0, 7357);
+  solver.sidBatchFixing = true;
+  for (const char* path : {"./test/cnf/3.cnf", "./test/cnf/11.cnf"}) {
+    INFO("cnf: " << path);
+    std::ifstream file(path);
+    if (!file.is_open()) FAIL("ERROR: Can't open file " << path);
+    sat::FactorGraph* graph = new sat::FactorGraph(file);
+    file.close();
+
+    CHECK(solver.SID(graph, 0.04) == sat::SAT);
+    CHECK(graph->IsSAT());
+    delete graph;
+  }
+};
@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+// Solve the cnf with SID and return the result followed by the value of every
+// variable (-1 if not assigned)
+std::vector<int> solveWithThreads(const std::string& path, int threads,
+                                  bool incrementalBiases = true,
+                                  bool batchFixing = false) {
+  std::ifstream file(path);
+  if (!file.is_open()) FAIL("ERROR: Can't open file " + path);
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.numThreads = threads;
+  solver.deterministic = true;
+  solver.parallelGrain = 16;  // Small tasks to use all threads in small cnf
+  solver.sidIncrementalBiases = incrementalBiases;
+  solver.sidBatchFixing = batchFixing;
+
+  std::vector<int> assignment;
+  assignment.push_back(solver.SID(graph, 0.04));
+  for (sat::Variable* var : graph->variables) {
+    assignment.push_back(var->assigned ? var->value : -1);
+  }
+
+  delete graph;
+  return assignment;
+}
+
+TEST_CASE("Solver - Deterministic mode (1, 2 and 8 threads)", "[integration]") {
+  const char* files[] = {"./test/cnf/1.cnf", "./test/cnf/2.cnf",
+                         "./test/cnf/3.cnf", "./test/cnf/6.cnf",
+                         "./test/cnf/8.cnf", "./test/cnf/10.cnf",
+                         "./test/cnf/11.cnf"};
+
+  for (const char* path : files) {
+    std::vector<int> sequential = solveWithThreads(path, 1);
+
+    INFO("cnf: " << path);
+    CHECK(solveWithThreads(path, 2) == sequential);
+    CHECK(solveWithThreads(path, 8) == sequential);
+  }
+};
+
+TEST_CASE("Solver - Incremental biases (same as evaluating all)",
+          "[integration]") {
+  const char* files[] = {"./test/cnf/1.cnf", "./test/cnf/6.cnf",
+                         "./test/cnf/10.cnf", "./test/cnf/11.cnf"};
+
+  for (const char* path : files) {
+    INFO("cnf: " << path);
+    CHECK(solveWithThreads(path, 1, true) == solveWithThreads(path, 1, false));
+    CHECK(solveWithThreads(path, 2, true) == solveWithThreads(path, 2, false));
+  }
+};
+
+TEST_CASE("Solver - Batch fixing (1, 2 and 8 threads)", "[integration]") {
+  const char* files[] = {"./test/cnf/1.cnf", "./test/cnf/6.cnf",
+                         "./test/cnf/10.cnf", "./test/cnf/11.cnf"};
+
+  for (const char* path : files) {
+    std::vector<int> sequential = solveWithThreads(path, 1, true, true);
+
+    INFO("cnf: " << path);
+    CHECK(solveWithThreads(path, 2, true, true) == sequential);
+    CHECK(solveWithThreads(path, 8, true, true) == sequential);
+    CHECK(solveWithThreads(path, 2, false, true) == sequential);
+  }
+
+  CHECK(solveWithThreads("./test/cnf/11.cnf", 2, true, true)[0] == sat::SAT);
+};
@@ -0,0 +1,29 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Portfolio.hpp>
+
+TEST_CASE("Solver - Portfolio (first SAT configuration wins)",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  sat::Portfolio portfolio;
+  portfolio.numThreads = 2;
+  portfolio.configs = {{0.04, 7357},
+                       {0.01, 7358},
+                       {0.04, 7359, sat::COMMUNITY_SCHEDULE}};
+
+  sat::PortfolioResult result = portfolio.Run(graph);
+
+  REQUIRE(result.result == sat::SAT);
+  REQUIRE(result.winner >= 0);
+  CHECK(result.results[result.winner] == sat::SAT);
+  CHECK(graph->IsSAT());
+
+  delete graph;
+};
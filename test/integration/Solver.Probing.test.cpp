@@ -0,0 +1,36 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+// SID with large steps and three retries, which run out unless probing fixes
+// the failed literals left by the first steps without using them
+sat::AlgorithmResult solveWithProbing(bool probing, int& failedLiterals) {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 1);
+  solver.sidProbing = probing;
+  solver.sidMaxRetries = 3;
+
+  sat::AlgorithmResult result = solver.SID(graph, 0.34);
+  if (result == sat::SAT) CHECK(graph->IsSAT());
+  failedLiterals = solver.totalFailedLiterals;
+
+  delete graph;
+  return result;
+}
+
+TEST_CASE("Solver - Failed literal probing", "[integration]") {
+  int failedLiterals;
+  CHECK(solveWithProbing(false, failedLiterals) == sat::CONTRADICTION);
+  CHECK(failedLiterals == 0);
+
+  CHECK(solveWithProbing(true, failedLiterals) == sat::SAT);
+  CHECK(failedLiterals > 0);
+};
@@ -0,0 +1,66 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+TEST_CASE("Solver - Residual solved by CDCL when walksat gives up",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.residualSolver = sat::WALKSAT_CDCL_RESIDUAL;
+  solver.wsMaxTries = 0;
+
+  REQUIRE(solver.SID(graph, 0.01) == sat::SAT);
+  CHECK(solver.totalConflicts > 0);
+  CHECK(graph->IsSAT());
+
+  delete graph;
+};
+
+TEST_CASE("Solver - Residual solver before the paramagnetic state",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.sidResidualDensity = 0.95;  // 11.cnf has 4 clauses per variable
+  solver.wsMaxFlips = 100 * N;
+
+  REQUIRE(solver.SID(graph, 0.01) == sat::SAT);
+  CHECK(solver.totalResidualSwitches == 1);
+  CHECK(solver.totalSPIterations == 0);
+  CHECK(graph->IsSAT());
+
+  delete graph;
+};
+
+TEST_CASE("Solver - Decimation goes on when the residual solver gives up",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.sidResidualVariables = N;
+  solver.wsMaxTries = 0;
+
+  // Walksat gives up at once, on the first residual and on the one at the
+  // paramagnetic state
+  REQUIRE(solver.SID(graph, 0.01) == sat::INDETERMINATE);
+  CHECK(solver.totalResidualSwitches >= 1);
+  CHECK(solver.totalSPIterations > 0);
+
+  delete graph;
+};
@@ -0,0 +1,96 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Features.hpp>
+#include <Selector.hpp>
+#include <Solver.hpp>
+
+TEST_CASE("Selector - Features of the formula", "[integration]") {
+  std::ifstream file("./test/cnf/3.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/3.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  sat::InstanceFeatures features = sat::ExtractFeatures(graph, false);
+  CHECK(features.variables == 4);
+  CHECK(features.clauses == 5);
+  CHECK(features.literals == 11);
+  CHECK(features.ratio == Approx(1.25));
+  CHECK(features.clauseLengthMean == Approx(2.2));
+  CHECK(features.degreeMean == Approx(2.75));
+  CHECK(features.positiveFraction == Approx(8.0 / 11.0));
+  CHECK(features.polarityImbalance == Approx(7.0 / 12.0));
+  CHECK(features.threshold == Approx(1.0 + 0.2 * 3.267));
+  CHECK(features.modularity == -1.0);
+
+  // Only the formula left by the assignment counts: X1 = true satisfies the
+  // clauses 1 and 3 and leaves ¬X2 alone in clause 2
+  graph->variables[0]->AssignValue(true);
+  for (sat::Clause* clause : graph->clauses) clause->UpdateState();
+  features = sat::ExtractFeatures(graph);
+  CHECK(features.variables == 3);
+  CHECK(features.clauses == 3);
+  CHECK(features.literals == 6);
+  CHECK(features.modularity >= -0.5);
+  CHECK(features.modularity <= 1.0);
+
+  delete graph;
+};
+
+TEST_CASE("Selector - Thresholds of random k-SAT", "[integration]") {
+  CHECK(sat::RandomKSATThreshold(2) == Approx(1.0));
+  CHECK(sat::RandomKSATThreshold(3) == Approx(4.267));
+  CHECK(sat::RandomKSATThreshold(3.5) == Approx((4.267 + 9.931) / 2));
+  CHECK(sat::RandomKSATThreshold(7) == Approx(87.79));
+  CHECK(sat::RandomKSATThreshold(8) == Approx(176.54).epsilon(0.01));
+};
+
+TEST_CASE("Selector - Choice from the default table", "[integration]") {
+  sat::InstanceFeatures features;
+
+  features.relativeDensity = 0.8;
+  CHECK(sat::SelectEngine(features).strategy == sat::LOCAL_SEARCH_ONLY);
+
+  features.relativeDensity = 0.96;
+  sat::EngineChoice choice = sat::SelectEngine(features);
+  CHECK(choice.strategy == sat::SP_DECIMATION);
+  CHECK(choice.schedule == sat::RANDOM_SCHEDULE);
+  CHECK(choice.fraction == 0.04);
+
+  features.relativeDensity = 0.99;
+  CHECK(sat::SelectEngine(features).fraction < 0.01);
+
+  features.modularity = 0.8;
+  CHECK(sat::SelectEngine(features).schedule == sat::COMMUNITY_SCHEDULE);
+
+  // First matching row, or the last one
+  std::vector<sat::SelectorRule> table = {
+      {0.5, -1.0, {sat::BP_DECIMATION, 0.02}},
+      {0.9, -1.0, {sat::SP_DECIMATION, 0.03}},
+  };
+  features.relativeDensity = 0.4;
+  CHECK(sat::SelectEngine(features, table).strategy == sat::BP_DECIMATION);
+  features.relativeDensity = 1.2;
+  CHECK(sat::SelectEngine(features, table).fraction == 0.03);
+};
+
+TEST_CASE("Selector - Local search without SP below the threshold",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  sat::EngineChoice choice = sat::SelectEngine(sat::ExtractFeatures(graph));
+  REQUIRE(choice.strategy == sat::LOCAL_SEARCH_ONLY);
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  REQUIRE(sat::SolveWithChoice(solver, graph, choice) == sat::SAT);
+  CHECK(solver.totalSPIterations == 0);
+  CHECK(graph->IsSAT());
+
+  delete graph;
+};
@@ -0,0 +1,49 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+TEST_CASE("Solver - Time budget (best walksat assignment is kept)",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  // A pure random walk does not solve the residual before the deadline
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.wsNoise = 1.0;
+  solver.wsMaxFlips = 1 << 30;
+  solver.timeBudget = 0.2;
+
+  REQUIRE(solver.SID(graph, 0.01) == sat::TIMEOUT);
+
+  int satisfied = 0;
+  for (sat::Clause* clause : graph->clauses) satisfied += clause->IsSAT();
+  CHECK(solver.bestSatisfiedClauses == satisfied);
+  CHECK(satisfied > 0);
+  CHECK(satisfied < (int)graph->clauses.size());
+
+  delete graph;
+};
+
+TEST_CASE("Solver - Time budget (stops SP)", "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  int N = graph->variables.size();
+  sat::Solver solver(N, (double)graph->clauses.size() / N, 7357);
+  solver.spEpsilon = 0.0;
+  solver.spMaxIt = 1 << 30;
+  solver.timeBudget = 0.1;
+
+  CHECK(solver.SID(graph, 0.01) == sat::TIMEOUT);
+  CHECK(solver.bestSatisfiedClauses == 0);
+
+  delete graph;
+};
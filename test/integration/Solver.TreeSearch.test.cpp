@@ -0,0 +1,29 @@
+#include <catch2/catch.hpp>
+#include <iostream>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <TreeSearch.hpp>
+
+TEST_CASE("Solver - TreeSearch (branches on close decimation choices)",
+          "[integration]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  sat::TreeSearch search(7357, 0.04);
+  search.numThreads = 2;
+  search.branchGap = 1.0;  // Every step branches
+  search.maxBranches = 8;
+
+  sat::TreeSearchResult result = search.Run(graph);
+
+  REQUIRE(result.result == sat::SAT);
+  CHECK(result.branches > 1);
+  CHECK(result.branches <= 8);
+  CHECK(result.explored >= 1);
+  CHECK(graph->IsSAT());
+
+  delete graph;
+};
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <random>
+
+// Project headders
+#include <BiasQueue.hpp>
+#include <FactorGraph.hpp>
+#include <Solver.hpp>
+
+// Variables popped from the queue until it is empty
+static std::vector<sat::Variable*> popAll(sat::BiasQueue& queue) {
+  std::vector<sat::Variable*> order;
+  while (!queue.empty()) {
+    order.push_back(queue.Top());
+    queue.Remove(queue.Top());
+  }
+  return order;
+}
+
+TEST_CASE("BiasQueue - Pop order (same as a full sort)", "[unit]") {
+  // Random biases with NaN and repeated ones, so the ties are broken by id
+  std::mt19937 generator(7357);
+  std::uniform_real_distribution<> random01;
+  std::vector<sat::Variable*> variables;
+  for (unsigned id = 1; id <= 500; id++) {
+    sat::Variable* var = new sat::Variable(id);
+    double r = random01(generator);
+    var->evalValue = r < 0.05 ? NAN : r < 0.15 ? 0.5 : random01(generator);
+    variables.push_back(var);
+  }
+
+  sat::BiasQueue queue;
+  queue.Reset(variables);
+  for (sat::Variable* var : variables) queue.Update(var);
+  REQUIRE(queue.size() == variables.size());
+
+  std::vector<sat::Variable*> sorted = variables;
+  std::sort(sorted.begin(), sorted.end(), sat::DecimationOrder);
+  CHECK(popAll(queue) == sorted);
+
+  // Updates of some biases and removals of some variables
+  for (sat::Variable* var : variables) queue.Update(var);
+  for (size_t v = 0; v < variables.size(); v += 3) {
+    variables[v]->evalValue = -random01(generator);
+    queue.Update(variables[v]);
+  }
+  for (size_t v = 1; v < variables.size(); v += 7) queue.Remove(variables[v]);
+
+  sorted.clear();
+  for (size_t v = 0; v < variables.size(); v++) {
+    if (v % 7 != 1) sorted.push_back(variables[v]);
+  }
+  std::sort(sorted.begin(), sorted.end(), sat::DecimationOrder);
+  CHECK(queue.Contains(variables[0]));
+  CHECK(!queue.Contains(variables[1]));
+
+  // Changes not given to the queue are not seen
+  variables[2]->evalValue = 2.0;
+  CHECK(popAll(queue) == sorted);
+
+  for (sat::Variable* var : variables) delete var;
+};
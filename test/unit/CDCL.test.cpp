@@ -0,0 +1,106 @@
+#include <catch2/catch.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Project headders
+#include <CDCL.hpp>
+
+TEST_CASE("CDCL - Satisfiable formula", "[unit]") {
+  std::vector<std::vector<int>> clauses = {
+      {1, 2, -3}, {-1, 3}, {-2, 3}, {-3, 4}, {-4, -1, 2}, {1, -2}};
+
+  sat::CDCL solver(4);
+  for (const std::vector<int>& clause : clauses) {
+    REQUIRE(solver.AddClause(clause));
+  }
+
+  REQUIRE(solver.Solve() == sat::SAT);
+  for (const std::vector<int>& clause : clauses) {
+    bool satisfied = false;
+    for (int literal : clause) {
+      if (solver.Value(std::abs(literal)) == (literal > 0)) satisfied = true;
+    }
+    CHECK(satisfied);
+  }
+};
+
+TEST_CASE("CDCL - Unsatisfiable formula (3 pigeons, 2 holes)", "[unit]") {
+  // Variable 2 * p + h + 1: pigeon p in hole h
+  sat::CDCL solver(6);
+  for (int p = 0; p < 3; p++) solver.AddClause({2 * p + 1, 2 * p + 2});
+  for (int h = 0; h < 2; h++) {
+    for (int p = 0; p < 3; p++) {
+      for (int q = p + 1; q < 3; q++) {
+        solver.AddClause({-(2 * p + h + 1), -(2 * q + h + 1)});
+      }
+    }
+  }
+
+  CHECK(solver.Solve() == sat::CONTRADICTION);
+  CHECK(solver.totalConflicts > 0);
+};
+
+TEST_CASE("CDCL - Conflicting units", "[unit]") {
+  sat::CDCL solver(2);
+  CHECK(solver.AddClause({1, 2}));
+  CHECK(solver.AddClause({-1}));
+  CHECK_FALSE(solver.AddClause({-2}));
+  CHECK(solver.Solve() == sat::CONTRADICTION);
+};
+
+TEST_CASE("CDCL - Learnt clauses deleted (7 pigeons, 6 holes)", "[unit]") {
+  // Variable 6 * p + h + 1: pigeon p in hole h
+  sat::CDCL solver(42);
+  for (int p = 0; p < 7; p++) {
+    std::vector<int> holes;
+    for (int h = 0; h < 6; h++) holes.push_back(6 * p + h + 1);
+    solver.AddClause(holes);
+  }
+  for (int h = 0; h < 6; h++) {
+    for (int p = 0; p < 7; p++) {
+      for (int q = p + 1; q < 7; q++) {
+        solver.AddClause({-(6 * p + h + 1), -(6 * q + h + 1)});
+      }
+    }
+  }
+
+  // Many reductions before the proof is complete
+  solver.reduceBase = 50;
+  solver.reduceIncrement = 10;
+  CHECK(solver.Solve() == sat::CONTRADICTION);
+  CHECK(solver.totalConflicts > 500);
+  CHECK(solver.totalDeleted > 0);
+};
+
+TEST_CASE("CDCL - Learnt clauses deleted (random 3-SAT)", "[unit]") {
+  std::ifstream file("./test/cnf/11.cnf");
+  if (!file.is_open()) FAIL("ERROR: Can't open file ./test/cnf/11.cnf");
+  std::vector<std::vector<int>> clauses;
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == 'c' || line[0] == 'p') continue;
+    std::istringstream literals(line);
+    std::vector<int> clause;
+    for (int literal; literals >> literal && literal != 0;)
+      clause.push_back(literal);
+    clauses.push_back(clause);
+  }
+
+  sat::CDCL solver(300);
+  for (const std::vector<int>& clause : clauses) {
+    REQUIRE(solver.AddClause(clause));
+  }
+
+  solver.reduceBase = 50;
+  solver.reduceIncrement = 10;
+  REQUIRE(solver.Solve() == sat::SAT);
+  CHECK(solver.totalDeleted > 0);
+  for (const std::vector<int>& clause : clauses) {
+    bool satisfied = false;
+    for (int literal : clause) {
+      if (solver.Value(std::abs(literal)) == (literal > 0)) satisfied = true;
+    }
+    CHECK(satisfied);
+  }
+};
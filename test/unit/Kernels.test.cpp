@@ -0,0 +1,264 @@
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <random>
+
+// Project headders
+#include <FactorGraph.hpp>
+#include <Kernels.hpp>
+
+// Graph of the cnf with random surveys (a few of them 1 and 0, the special
+// cases of the subproducts) and the subproducts of every variable
+static sat::FactorGraph* graphWithSurveys(const std::string& path,
+                                          const sat::Kernels* kernels) {
+  std::ifstream file(path);
+  if (!file.is_open()) FAIL("ERROR: Can't open file " + path);
+  sat::FactorGraph* graph = new sat::FactorGraph(file);
+  file.close();
+
+  std::mt19937 generator(7357);
+  std::uniform_real_distribution<> random01;
+  for (sat::Edge* edge : graph->edges) {
+    double r = random01(generator);
+    edge->survey = r < 0.05 ? 1.0 : r < 0.1 ? 0.0 : random01(generator);
+  }
+  for (sat::Variable* var : graph->variables) kernels->computeSubProducts(var);
+  return graph;
+}
+
+// Equal values, NaN included (a variable with surveys of 1 on both sides)
+static bool same(double a, double b) {
+  return (std::isnan(a) && std::isnan(b)) || a == b;
+}
+
+// Variants built for this binary that the CPU can run
+static std::vector<const sat::Kernels*> testedKernels() {
+  std::vector<const sat::Kernels*> kernels;
+  for (const char* name : {"baseline", "avx2", "avx512"}) {
+    const sat::Kernels* variant = sat::GetKernels(name);
+    if (variant == nullptr) continue;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (variant->name == std::string("avx2") &&
+        !(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")))
+      continue;
+    if (variant->name == std::string("avx512") &&
+        !(__builtin_cpu_supports("avx512f") &&
+          __builtin_cpu_supports("avx512vl") &&
+          __builtin_cpu_supports("avx512dq")))
+      continue;
+#endif
+    kernels.push_back(variant);
+  }
+  return kernels;
+}
+
+TEST_CASE("Kernels - Variants (same as baseline)", "[unit]") {
+  const sat::Kernels* baseline = sat::GetKernels("baseline");
+  for (const sat::Kernels* kernels : testedKernels()) {
+    for (bool bp : {false, true}) {
+      INFO("kernels: " << kernels->name << ", bp: " << bp);
+      sat::FactorGraph* expected =
+          graphWithSurveys("./test/cnf/14.cnf", baseline);
+      sat::FactorGraph* graph = graphWithSurveys("./test/cnf/14.cnf", kernels);
+
+      for (int sweep = 0; sweep < 3; sweep++) {
+        for (size_t c = 0; c < graph->clauses.size(); c++) {
+          sat::Clause* clause = graph->clauses[c];
+          sat::Clause* other = expected->clauses[c];
+          double diff = bp ? kernels->updateSurveysBP[clause->bucket](clause)
+                           : kernels->updateSurveys[clause->bucket](clause);
+          double expectedDiff =
+              bp ? baseline->updateSurveysBP[other->bucket](other)
+                 : baseline->updateSurveys[other->bucket](other);
+          CHECK(same(diff, expectedDiff));
+        }
+        for (size_t e = 0; e < graph->edges.size(); e++)
+          CHECK(same(graph->edges[e]->survey, expected->edges[e]->survey));
+      }
+
+      std::vector<sat::Variable*>& vars = graph->variables;
+      std::vector<sat::Variable*>& expectedVars = expected->variables;
+      CHECK(same(kernels->evaluateVars(vars.data(), vars.size(), bp),
+                 baseline->evaluateVars(expectedVars.data(),
+                                        expectedVars.size(), bp)));
+      for (size_t v = 0; v < vars.size(); v++) {
+        CHECK(same(vars[v]->Hp, expectedVars[v]->Hp));
+        CHECK(same(vars[v]->Hz, expectedVars[v]->Hz));
+        CHECK(same(vars[v]->Hm, expectedVars[v]->Hm));
+        CHECK(same(vars[v]->evalValue, expectedVars[v]->evalValue));
+      }
+
+      delete graph;
+      delete expected;
+    }
+  }
+};
+
+TEST_CASE("Kernels - Batched biases (same as one variable at a time)",
+          "[unit]") {
+  for (const sat::Kernels* kernels : testedKernels()) {
+    for (bool bp : {false, true}) {
+      INFO("kernels: " << kernels->name << ", bp: " << bp);
+      sat::FactorGraph* single =
+          graphWithSurveys("./test/cnf/11.cnf", kernels);
+      sat::FactorGraph* batched = new sat::FactorGraph(*single);
+      for (sat::Variable* var : batched->variables)
+        kernels->computeSubProducts(var);
+
+      // Sum of the variables with a bias (the others are NaN)
+      double sumMaxBias = 0.0;
+      std::vector<sat::Variable*> defined, undefined;
+      for (size_t v = 0; v < single->variables.size(); v++) {
+        sat::Variable* var = single->variables[v];
+        if (bp)
+          kernels->evaluateVarBP(var);
+        else
+          kernels->evaluateVar(var);
+        double bias = bp ? var->evalValue : std::max(var->Hp, var->Hm);
+        if (std::isnan(bias)) {
+          undefined.push_back(batched->variables[v]);
+        } else {
+          sumMaxBias += bias;
+          defined.push_back(batched->variables[v]);
+        }
+      }
+
+      // Not a multiple of the block of the kernel, so the last one is partial
+      REQUIRE(defined.size() % 64 != 0);
+      CHECK(kernels->evaluateVars(defined.data(), defined.size(), bp) ==
+            sumMaxBias);
+      if (!undefined.empty()) {
+        CHECK(std::isnan(kernels->evaluateVars(undefined.data(),
+                                               undefined.size(), bp)));
+      }
+
+      const std::vector<sat::Variable*>& vars = batched->variables;
+      for (size_t v = 0; v < vars.size(); v++) {
+        const sat::Variable* expected = single->variables[v];
+        CHECK(same(vars[v]->Hp, expected->Hp));
+        CHECK(same(vars[v]->Hz, expected->Hz));
+        CHECK(same(vars[v]->Hm, expected->Hm));
+        CHECK(same(vars[v]->evalValue, expected->evalValue));
+      }
+
+      delete batched;
+      delete single;
+    }
+  }
+};
+
+// Survey of every enabled edge of the clause from the SP (or BP) equations:
+// the product over the other literals of the probability that their variable
+// is forced to violate the clause, with the cavity products computed directly
+static std::vector<double> directSurveys(const sat::Clause* clause, bool bp) {
+  std::vector<double> sub;
+  for (sat::Edge* edge : clause->allNeighbourEdges) {
+    double same = 1.0, opposite = 1.0;
+    for (sat::Edge* other : edge->variable->allNeighbourEdges) {
+      if (other == edge || !other->enabled) continue;
+      (other->type == edge->type ? same : opposite) *= 1.0 - other->survey;
+    }
+    double wn = bp ? same : same * (1.0 - opposite);
+    sub.push_back(wn / (wn + opposite));
+  }
+
+  std::vector<double> surveys;
+  for (size_t i = 0; i < sub.size(); i++) {
+    double product = 1.0;
+    for (size_t j = 0; j < sub.size(); j++) {
+      if (j != i) product *= sub[j];
+    }
+    surveys.push_back(product);
+  }
+  return surveys;
+}
+
+// Equal values up to rounding
+static bool close(double a, double b) {
+  return std::abs(a - b) <= 1.0e-12;
+}
+
+TEST_CASE("Kernels - Prefix and suffix products (same as direct products)",
+          "[unit]") {
+  for (const sat::Kernels* kernels : testedKernels()) {
+    for (bool bp : {false, true}) {
+      INFO("kernels: " << kernels->name << ", bp: " << bp);
+      sat::FactorGraph* graph = graphWithSurveys("./test/cnf/14.cnf", kernels);
+
+      // Surveys of 1 only in positive literals: with both signs the cavity
+      // products can be 0/0, and the kernels take a NaN survey as 1
+      for (sat::Edge* edge : graph->edges) {
+        if (!edge->type && edge->survey == 1.0) edge->survey = 0.5;
+      }
+      for (sat::Variable* var : graph->variables)
+        kernels->computeSubProducts(var);
+
+      int longClauses = 0;
+      for (sat::Clause* clause : graph->clauses) {
+        if (clause->bucket == sat::LONG_CLAUSE) longClauses++;
+        std::vector<double> expected = directSurveys(clause, bp);
+        double maxDiff = 0.0;
+        for (size_t i = 0; i < expected.size(); i++) {
+          double diff =
+              std::abs(clause->allNeighbourEdges[i]->survey - expected[i]);
+          if (diff > maxDiff) maxDiff = diff;
+        }
+
+        double diff = bp ? kernels->updateSurveysBP[clause->bucket](clause)
+                         : kernels->updateSurveys[clause->bucket](clause);
+        CHECK(close(diff, maxDiff));
+        for (size_t i = 0; i < expected.size(); i++) {
+          CHECK(close(clause->allNeighbourEdges[i]->survey, expected[i]));
+        }
+      }
+      CHECK(longClauses == 4);
+
+      delete graph;
+    }
+  }
+};
+
+TEST_CASE("Kernels - Clause buckets (same as the generic kernel)", "[unit]") {
+  for (const sat::Kernels* kernels : testedKernels()) {
+    for (bool bp : {false, true}) {
+      INFO("kernels: " << kernels->name << ", bp: " << bp);
+      sat::FactorGraph* bucketed =
+          graphWithSurveys("./test/cnf/14.cnf", kernels);
+      sat::FactorGraph* generic =
+          graphWithSurveys("./test/cnf/14.cnf", kernels);
+
+      // Disabled literals and assigned variables in the short clauses too
+      for (sat::FactorGraph* graph : {bucketed, generic}) {
+        for (size_t e = 0; e < graph->edges.size(); e += 7)
+          graph->edges[e]->enabled = false;
+        for (size_t v = 0; v < graph->variables.size(); v += 11)
+          graph->variables[v]->AssignValue(true);
+        for (sat::Variable* var : graph->variables)
+          kernels->computeSubProducts(var);
+      }
+
+      auto update = [&](sat::Clause* clause, sat::ClauseBucket bucket) {
+        return bp ? kernels->updateSurveysBP[bucket](clause)
+                  : kernels->updateSurveys[bucket](clause);
+      };
+
+      for (int sweep = 0; sweep < 3; sweep++) {
+        for (size_t c = 0; c < bucketed->clauses.size(); c++) {
+          sat::Clause* clause = bucketed->clauses[c];
+          // The medium kernel has buffers of LONG_CLAUSE_LENGTH literals
+          sat::ClauseBucket bucket = clause->bucket == sat::LONG_CLAUSE
+                                         ? sat::LONG_CLAUSE
+                                         : sat::MEDIUM_CLAUSE;
+          CHECK(same(update(clause, clause->bucket),
+                     update(generic->clauses[c], bucket)));
+        }
+
+        for (size_t e = 0; e < bucketed->edges.size(); e++)
+          CHECK(same(bucketed->edges[e]->survey, generic->edges[e]->survey));
+      }
+
+      delete generic;
+      delete bucketed;
+    }
+  }
+};